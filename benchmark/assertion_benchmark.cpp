@@ -0,0 +1,128 @@
+/**
+ * Micro benchmark of the assertion hot path.
+ *
+ * Measures passing UNIT_ASSERT_EQUAL in a tight loop, and for comparison an emulation
+ * of the previous implementation, which built a cutee::info with heap strings and
+ * wrapped the check in a std::function for every assertion.
+ **/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../include/cutee.hpp"
+
+namespace legacy
+{
+
+struct info
+{
+   std::string _message;
+   std::string _file;
+   int         _line;
+};
+
+template<class... Ts>
+struct assertion
+{
+   std::function<bool(Ts...)> _assert_function;
+   std::tuple<Ts...>          _args;
+   info                       _info;
+
+   template<size_t... I>
+   bool execute_internal(std::index_sequence<I...>) const
+   {
+      return _assert_function(std::get<I>(_args)...);
+   }
+
+   bool execute() const
+   {
+      return execute_internal(std::index_sequence_for<Ts...>{});
+   }
+};
+
+unsigned long num_assertions = 0;
+
+template<class... Ts>
+void execute_assertion(assertion<Ts...>&& asrt)
+{
+   num_assertions += 1;
+   if(!asrt.execute())
+   {
+      std::abort();
+   }
+}
+
+template<class T, class U>
+void assert_equal(T&& t, U&& u, info&& i)
+{
+   execute_assertion
+      (  assertion<T, U>
+         {  [](T&& lhs, U&& rhs) { return lhs == rhs; }
+         ,  std::forward_as_tuple(std::forward<T>(t), std::forward<U>(u))
+         ,  std::move(i)
+         }
+      );
+}
+
+} /* namespace legacy */
+
+using clock_type = std::chrono::steady_clock;
+
+struct result
+{
+   double _legacy  = 0.0;
+   double _current = 0.0;
+};
+
+result bench_result;
+
+struct assertion_benchmark
+{
+   std::vector<int> _data;
+
+   assertion_benchmark(std::size_t n)
+      :  _data(n)
+   {
+      for(std::size_t i = 0; i < n; ++i)
+      {
+         _data[i] = static_cast<int>(i);
+      }
+   }
+
+   void run()
+   {
+      auto start = clock_type::now();
+      for(std::size_t i = 0; i < _data.size(); ++i)
+      {
+         legacy::assert_equal(_data[i], static_cast<int>(i), legacy::info{"element differs", __FILE__, __LINE__});
+      }
+      bench_result._legacy = _data.size() / std::chrono::duration<double>(clock_type::now() - start).count();
+
+      start = clock_type::now();
+      for(std::size_t i = 0; i < _data.size(); ++i)
+      {
+         UNIT_ASSERT_EQUAL(_data[i], static_cast<int>(i), "element differs");
+      }
+      bench_result._current = _data.size() / std::chrono::duration<double>(clock_type::now() - start).count();
+   }
+};
+
+int main(int argc, char* argv[])
+{
+   std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+   cutee::suite suite("assertion benchmark");
+   suite.add_test<assertion_benchmark>("assertions in tight loop", n);
+   bool ok = suite.run(std::cout, cutee::format::raw);
+
+   std::printf("assertions: %zu\n", n);
+   std::printf("previous implementation: %12.4g assertions/s\n", bench_result._legacy);
+   std::printf("current  implementation: %12.4g assertions/s\n", bench_result._current);
+   std::printf("speedup: %.1fx\n", bench_result._current / bench_result._legacy);
+
+   return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,123 @@
+/**
+ * Micro benchmark of message formatting.
+ *
+ * Formats a large failure dump with the formater of a formated_writer, and for comparison
+ * with an emulation of the previous implementation, which searched for tags with std::regex
+ * and restarted the search from the beginning of the message after each replacement.
+ **/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <regex>
+#include <string>
+
+#include "../include/cutee.hpp"
+
+namespace legacy
+{
+
+std::string& replace_in_string(const cutee::formater& f, std::string& str)
+{
+   static const std::map<std::string, const char* (cutee::formater::*)() const> map
+      {  {"bold_on" ,      &cutee::formater::bold_on       }
+      ,  {"bold_off",      &cutee::formater::bold_off      }
+      ,  {"default_color", &cutee::formater::default_color }
+      ,  {"warning_color", &cutee::formater::warning_color }
+      ,  {"file_color",    &cutee::formater::file_color    }
+      ,  {"type_color",    &cutee::formater::type_color    }
+      ,  {"name_color",    &cutee::formater::name_color    }
+      ,  {"value_color",   &cutee::formater::value_color   }
+      };
+   static const std::regex regex{"\\[/(.*?)\\]"};
+
+   std::smatch match;
+   while(std::regex_search(str, match, regex))
+   {
+      auto iter = map.find(cutee::detail::remove_whitespace_copy(match.str(1)));
+      if(iter != map.end())
+      {
+         str.replace(match.prefix().second, match.suffix().first, (f.*(iter->second))());
+      }
+      else
+      {
+         str.erase(match.prefix().second, match.suffix().first);
+      }
+   }
+   return str;
+}
+
+} /* namespace legacy */
+
+using clock_type = std::chrono::steady_clock;
+
+/**
+ * Create a failure dump looking like the output of a failing suite.
+ **/
+std::string create_dump(std::size_t nfailures)
+{
+   std::string dump;
+   for(std::size_t i = 0; i < nfailures; ++i)
+   {
+      dump += "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n"
+              "[/name_color]   *** some test " + std::to_string(i) + " ***\n[/default_color]"
+              "   error        [/warning_color]element differs[/default_color]\n"
+              "   file         [/file_color]/path/to/some/test_file.cpp:123[/default_color]\n\n"
+              "   expected     [/value_color]" + std::to_string(i) + "[/default_color] [[/type_color]i[/default_color]]\n"
+              "   got          [/value_color]" + std::to_string(i + 1) + "[/default_color] [[/type_color]i[/default_color]]\n";
+   }
+   return dump;
+}
+
+/**
+ * Run 'f' at least 'repeat' times and for at least a tenth of a second.
+ **/
+template<class F>
+double megabytes_per_second(std::size_t bytes, int repeat, F&& f)
+{
+   auto start = clock_type::now();
+   double seconds = 0.0;
+   long   count   = 0;
+   while(count < repeat || seconds < 0.1)
+   {
+      f();
+      ++count;
+      seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+   }
+   return static_cast<double>(bytes) * count / seconds / 1.0e6;
+}
+
+int main(int argc, char* argv[])
+{
+   std::size_t nfailures = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+   int         repeat    = argc > 2 ? std::atoi(argv[2]) : 3;
+
+   auto dump     = create_dump(nfailures);
+   auto formater = cutee::format::create(cutee::format::fancy);
+
+   std::string legacy_out;
+   double legacy = megabytes_per_second
+      (  dump.size()
+      ,  repeat
+      ,  [&]() { legacy_out = dump; legacy::replace_in_string(*formater, legacy_out); }
+      );
+
+   std::string current_out;
+   double current = megabytes_per_second
+      (  dump.size()
+      ,  repeat
+      ,  [&]() { current_out.clear(); formater->replace_into(dump, current_out); }
+      );
+
+   std::printf("message size: %zu bytes (%zu failures)\n", dump.size(), nfailures);
+   std::printf("previous implementation: %12.4g MB/s\n", legacy);
+   std::printf("current  implementation: %12.4g MB/s\n", current);
+   std::printf("speedup: %.1fx\n", current / legacy);
+
+   if(legacy_out != current_out)
+   {
+      std::printf("output differs!\n");
+      return EXIT_FAILURE;
+   }
+   return EXIT_SUCCESS;
+}
@@ -11,7 +11,10 @@
 #include "cutee/exceptions.hpp"
 #include "cutee/timer.hpp"
 #include "cutee/float_eq.hpp"
+#include "cutee/float_eq_par.hpp"
+#include "cutee/span.hpp"
 #include "cutee/function.hpp"
+#include "cutee/options.hpp"
 
 // Interface
 #include "cutee/macros.hpp"
@@ -19,6 +22,13 @@
 #include "cutee/container.hpp"
 #include "cutee/collection.hpp"
 #include "cutee/suite.hpp"
+#include "cutee/thread.hpp"
+#include "cutee/async_writer.hpp"
+#include "cutee/junit_writer.hpp"
+#include "cutee/jsonl_writer.hpp"
+#include "cutee/tap_writer.hpp"
+#include "cutee/binary_log.hpp"
 #include "cutee/performance_test.hpp"
+#include "cutee/alloc.hpp"
 
 #endif /* CUTEE_HPP_INCLUDED */
@@ -0,0 +1,149 @@
+#pragma once
+#ifndef CUTEE_ALLOC_HPP_INCLUDED
+#define CUTEE_ALLOC_HPP_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+
+namespace cutee
+{
+
+/**
+ * Heap allocation accounting. Counting is done by the global operator new/delete of the
+ * 'cutee_alloc' library, which must be linked into the test program explicitly.
+ * Counters are per thread, so allocations in threads started by a test are not counted for the test.
+ **/
+namespace alloc
+{
+
+/**
+ * Allocation counts.
+ **/
+struct counters
+{
+   std::uint64_t _allocations = 0;
+   std::uint64_t _frees       = 0;
+   std::uint64_t _bytes       = 0;   // bytes allocated
+
+   counters operator-(const counters& other) const
+   {
+      return counters{_allocations - other._allocations, _frees - other._frees, _bytes - other._bytes};
+   }
+};
+
+namespace detail
+{
+
+//! Counters of the calling thread (constant initialized, so operator new can use them at any time).
+inline thread_local counters current;
+
+//! Counters of the calling thread when its current test started (set by the suite).
+inline thread_local counters test_start;
+
+//! Set when operator new/delete of cutee_alloc are linked in.
+inline std::atomic<bool> installed{false};
+
+//! Depth of 'suspend' guards of the calling thread. Allocations and frees are not counted while non-zero.
+inline thread_local unsigned suspended = 0;
+
+} /* namespace detail */
+
+//! Are allocations counted (is cutee_alloc linked in).
+inline bool tracking()
+{
+   return detail::installed.load(std::memory_order_relaxed);
+}
+
+//! Allocations of the calling thread since it started.
+inline counters thread_counters()
+{
+   return detail::current;
+}
+
+//! Allocations of the calling thread since the current test started (including setup).
+inline counters test_counters()
+{
+   return detail::current - detail::test_start;
+}
+
+//! Mark the start of a test on the calling thread.
+inline void begin_test()
+{
+   detail::test_start = detail::current;
+}
+
+/**
+ * Scoped guard excluding allocations and frees of the calling thread from the counters.
+ * Used around cutee's own bookkeeping (recording failures, capturing output),
+ * so the counts of a test do not depend on e.g. how many of its assertions failed.
+ **/
+class suspend
+{
+   public:
+      suspend()
+      {
+         ++detail::suspended;
+      }
+
+      suspend(const suspend&) = delete;
+      suspend& operator=(const suspend&) = delete;
+
+      ~suspend()
+      {
+         --detail::suspended;
+      }
+};
+
+//! Description of an allocation limit, for failure messages.
+inline std::string describe_limit(std::uint64_t max)
+{
+   return tracking()
+      ?  "at most " + std::to_string(max) + " allocations expected"
+      :  std::string{"allocations are not counted (link with cutee_alloc)"};
+}
+
+} /* namespace alloc */
+
+/**
+ * Scoped guard failing the current test (as a soft failure) if the calling thread allocates
+ * while the guard is alive, or if allocations are not counted at all.
+ *
+ *    {
+ *       cutee::no_alloc_region guard;
+ *       hot_path();
+ *    }
+ **/
+class no_alloc_region
+{
+   private:
+      alloc::counters _start;
+      const char*     _file;
+      int             _line;
+
+   public:
+      explicit no_alloc_region
+         (  const char* file = __builtin_FILE()
+         ,  int line = __builtin_LINE()
+         )
+         :  _start(alloc::thread_counters())
+         ,  _file(file)
+         ,  _line(line)
+      {
+      }
+
+      no_alloc_region(const no_alloc_region&) = delete;
+      no_alloc_region& operator=(const no_alloc_region&) = delete;
+
+      //! Allocations in the region so far.
+      alloc::counters allocations() const
+      {
+         return alloc::thread_counters() - _start;
+      }
+
+      ~no_alloc_region();
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_ALLOC_HPP_INCLUDED */
@@ -3,9 +3,9 @@
 #define CUTEE_ASSERTER_HPP_INCLUDED
 
 #include "typedef.hpp"
+#include "alloc.hpp"
 
 #include <tuple>
-#include <functional>
 #include <cassert>
 
 namespace cutee
@@ -13,6 +13,11 @@ namespace cutee
 
 /**
  * Struct for carrying out assertions. Uses a static pointer to a suite.
+ *
+ * Assertion info 'I' is either a cutee::info or a cutee::lazy_info,
+ * and the check is passed to the suite as a template callable,
+ * so nothing is allocated or type erased unless the assertion fails.
+ * With severity 'S' soft, a failure is recorded and the test continues.
  **/
 struct asserter
 {
@@ -36,108 +41,135 @@ struct asserter
    /**
     * Assertions
     **/
-   /* Assert float equal with precision */
-   template<class T>
-   static void assertt(T&& t, info&& i)
+   /* Assert true */
+   template<severity S = severity::fatal, class T, class I>
+   static void assertt(T&& t, I&& i)
    {
       __assert_suite_ptr();
-      _suite_ptr->execute_assertion
-         (  assertion<T>{
-               [](T&& lhs){
-                  return bool(lhs);
-               }
-               ,  std::forward_as_tuple(std::forward<T>(t))
-               ,  std::move(i)
+      _suite_ptr->template execute_assertion<S>
+         (  [](const auto& lhs){
+               return bool(lhs);
             }
-         
+         ,  std::forward<I>(i)
+         ,  assertion_type::equal
+         ,  std::forward<T>(t)
          );
    }
    
+   /* Assert at most 'max' allocations by the calling thread in the current test (fails if allocations are not counted) */
+   template<severity S = severity::fatal, class I>
+   static void assert_max_allocations(std::uint64_t max, I&& i)
+   {
+      __assert_suite_ptr();
+      _suite_ptr->template execute_assertion<S>
+         (  [max](const auto& got){
+               return alloc::tracking() && got <= max;
+            }
+         ,  std::forward<I>(i)
+         ,  assertion_type::equal
+         ,  alloc::test_counters()._allocations
+         );
+   }
+
    /* Assert not */
-   template<class T>
-   static void assert_not(T&& t, info&& i)
+   template<severity S = severity::fatal, class T, class I>
+   static void assert_not(T&& t, I&& i)
    {
       __assert_suite_ptr();
-      i._type = assertion_type::not_equal;
-      _suite_ptr->execute_assertion
-         (  assertion<T>{
-               [](T&& lhs){
-                  return !bool(lhs);
-               }
-               ,  std::forward_as_tuple(std::forward<T>(t))
-               ,  std::move(i)
+      _suite_ptr->template execute_assertion<S>
+         (  [](const auto& lhs){
+               return !bool(lhs);
             }
-         
+         ,  std::forward<I>(i)
+         ,  assertion_type::not_equal
+         ,  std::forward<T>(t)
          );
    }
 
    /* Assert equal */
-   template<class T, class U>
-   static void assert_equal(T&& t, U&& u, info&& i)
+   template<severity S = severity::fatal, class T, class U, class I>
+   static void assert_equal(T&& t, U&& u, I&& i)
    {
       __assert_suite_ptr();
-      _suite_ptr->execute_assertion
-         (  assertion<T, U>{
-               [](T&& lhs, U&& rhs){
-                  return (lhs == rhs);
-               }
-               ,  std::forward_as_tuple(std::forward<T>(t), std::forward<U>(u))
-               ,  std::move(i)
+      _suite_ptr->template execute_assertion<S>
+         (  [](const auto& lhs, const auto& rhs){
+               return (lhs == rhs);
             }
-         
+         ,  std::forward<I>(i)
+         ,  assertion_type::equal
+         ,  std::forward<T>(t)
+         ,  std::forward<U>(u)
          );
    }
    
-   /* Assert float equal with precision */
-   template<class T, class U>
-   static void assert_not_equal(T&& t, U&& u, info&& i)
+   /* Assert not equal */
+   template<severity S = severity::fatal, class T, class U, class I>
+   static void assert_not_equal(T&& t, U&& u, I&& i)
    {
       __assert_suite_ptr();
-      i._type = assertion_type::not_equal;
-      _suite_ptr->execute_assertion
-         (  assertion<T, U>{
-               [](T&& lhs, U&& rhs){
-                  return (lhs != rhs);
-               }
-               ,  std::forward_as_tuple(std::forward<T>(t), std::forward<U>(u))
-               ,  std::move(i)
+      _suite_ptr->template execute_assertion<S>
+         (  [](const auto& lhs, const auto& rhs){
+               return (lhs != rhs);
             }
-         
+         ,  std::forward<I>(i)
+         ,  assertion_type::not_equal
+         ,  std::forward<T>(t)
+         ,  std::forward<U>(u)
          );
    }
 
    /* Assert float equal with precision */
-   template<class T, class U, class I>
-   static void assert_float_equal_prec(T&& t, U&& u, I&& ulps, info&& i)
+   template<severity S = severity::fatal, class T, class U, class P, class I>
+   static void assert_float_equal_prec(T&& t, U&& u, P&& ulps, I&& i)
+   {
+      __assert_suite_ptr();
+      _suite_ptr->template execute_assertion<S>
+         (  [](const auto& lhs, const auto& rhs, const auto& ulps){
+               return cutee::numeric::float_eq(lhs, rhs, ulps);
+            }
+         ,  std::forward<I>(i)
+         ,  assertion_type::equal
+         ,  std::forward<T>(t)
+         ,  std::forward<U>(u)
+         ,  std::forward<P>(ulps)
+         );
+   }
+   
+   /* Assert float equal with precision, comparing ranges on multiple threads.
+      The merged result of the comparison is passed on, so a failure is described from it without comparing again. */
+   template<severity S = severity::fatal, class T, class U, class P, class I>
+   static void assert_float_equal_par(T&& t, U&& u, P&& ulps, I&& i)
    {
       __assert_suite_ptr();
-      _suite_ptr->execute_assertion
-         (  assertion<T, U, I>{
-               [](T&& lhs, U&& rhs, I&& ulps){
-                  return cutee::numeric::float_eq(lhs, rhs, ulps);
-               }
-               ,  std::forward_as_tuple(std::forward<T>(t), std::forward<U>(u), std::forward<I>(ulps))
-               ,  std::move(i)
+      decltype(cutee::numeric::ulp_compare_range_par(t, u, ulps)) result;
+      _suite_ptr->template execute_assertion<S>
+         (  [](const auto& lhs, const auto& rhs, const auto& ulps, auto& result){
+               result = cutee::numeric::ulp_compare_range_par(lhs, rhs, ulps);
+               return result._equal;
             }
-         
+         ,  std::forward<I>(i)
+         ,  assertion_type::equal
+         ,  std::forward<T>(t)
+         ,  std::forward<U>(u)
+         ,  std::forward<P>(ulps)
+         ,  result
          );
    }
    
    /* Assert float equal to zero in comparisson with number with precision */
-   template<class T, class U, class I>
-   static void assert_float_numeq_zero_prec(T&& t, U&& u, I&& ulps, info&& i)
+   template<severity S = severity::fatal, class T, class U, class P, class I>
+   static void assert_float_numeq_zero_prec(T&& t, U&& u, P&& ulps, I&& i)
    {
       __assert_suite_ptr();
-      i._type = assertion_type::comp_zero;
-      _suite_ptr->execute_assertion
-         (  assertion<T, U, I>{
-               [](T&& lhs, U&& rhs, I&& ulps){
-                  return cutee::numeric::float_numeq_zero(lhs, rhs, ulps);
-               }
-               ,  std::forward_as_tuple(std::forward<T>(t), std::forward<U>(u), std::forward<I>(ulps))
-               ,  std::move(i)
+      _suite_ptr->template execute_assertion<S>
+         (  [](const auto& lhs, const auto& rhs, const auto& ulps){
+               return cutee::numeric::float_numeq_zero(lhs, rhs, ulps);
             }
-         
+         ,  std::forward<I>(i)
+         ,  assertion_type::comp_zero
+         ,  std::forward<T>(t)
+         ,  std::forward<U>(u)
+         ,  std::forward<P>(ulps)
          );
    }
 };
@@ -147,7 +179,7 @@ struct asserter
  **/
 inline void unit_assert_fcn(bool check, const std::string& message, const char* file, int line)
 {
-   cutee::asserter::assertt(check, cutee::info{message, file, line});
+   cutee::asserter::assertt(check, cutee::make_info([&message]() -> const std::string& { return message; }, file, line));
 }
 
 } /* namespace cutee */
@@ -3,14 +3,21 @@
 #define CUTEE_ASSERTION_HPP_INCLUDED
 
 #include <string>
-#include <functional>
 #include <tuple>
+#include <utility>
+#include <type_traits>
 
 namespace cutee
 {
 
 enum assertion_type : int { equal, not_equal, comp_zero };
 
+/**
+ * What happens when an assertion fails: a fatal assertion stops the test,
+ * a soft assertion (UNIT_EXPECT...) is recorded and the test continues.
+ **/
+enum class severity : int { fatal, soft };
+
 struct info
 {
    std::string _message;
@@ -19,23 +26,53 @@ struct info
    assertion_type _type = assertion_type::equal;
 };
 
+/**
+ * Message and source location of an assertion, used on the hot path.
+ * The message is a callable only invoked when the assertion fails,
+ * and the file is a compile time string, so a passing assertion allocates nothing.
+ **/
+template<class M>
+struct lazy_info
+{
+   M           _message;
+   const char* _file;
+   int         _line;
+};
+
+template<class M>
+lazy_info<std::decay_t<M> > make_info(M&& message, const char* file, int line)
+{
+   return lazy_info<std::decay_t<M> >{std::forward<M>(message), file, line};
+}
+
+namespace detail
+{
+
+/**
+ * Turn assertion info into a full info on failure.
+ **/
+inline info materialize_info(info&& i, assertion_type type)
+{
+   i._type = type;
+   return std::move(i);
+}
+
+template<class M>
+info materialize_info(lazy_info<M>&& i, assertion_type type)
+{
+   return info{std::string(i._message()), std::string(i._file ? i._file : ""), i._line, type};
+}
+
+} /* namespace detail */
+
+/**
+ * A failed assertion, holding the arguments and info used for creating the failure message.
+ **/
 template<class... Ts> 
 struct assertion
 {
-   std::function<bool(Ts...)> _assert_function;
    std::tuple<Ts...>          _args;
    info                       _info;
-   
-   template<size_t... I>
-   auto __execute_internal(std::index_sequence<I...>) const
-   {
-      return _assert_function(std::get<I>(_args)...);
-   }
-
-   auto execute() const 
-   {
-      return __execute_internal(std::index_sequence_for<Ts...>{});  
-   }
 
    constexpr auto size() const
    {
@@ -0,0 +1,355 @@
+#pragma once
+#ifndef CUTEE_ASYNC_WRITER_HPP_INCLUDED
+#define CUTEE_ASYNC_WRITER_HPP_INCLUDED
+
+#include "typedef.hpp"
+
+#ifdef CUTEE_HAVE_POSIX
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <string>
+#include <csignal>
+#include <cerrno>
+#include <iterator>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "formater.hpp"
+#include "writer.hpp"
+#include "ring_buffer.hpp"
+
+namespace cutee
+{
+
+/**
+ * Writer doing the formatting and writing on a background thread.
+ *
+ * Messages are pushed into a bounded lock-free ring buffer, so 'write' can be called from any number
+ * of test workers and only waits (backpressure) when the buffer is full. The background thread formats
+ * messages into a batch, which is written with write(2) when the buffer has been emptied or the batch is large.
+ * 'flush' waits until everything written before the call has been written to the file descriptor,
+ * and is called by the suite at the end of a run.
+ *
+ * On fatal signals (SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGTERM) pending output is written
+ * on a best-effort basis (without formatting), before the signal is passed on to the previous handler.
+ **/
+class async_writer
+   :  public writer
+{
+   private:
+      using formater_ptr_t = typename format::formater_ptr_t;
+
+      static constexpr std::size_t batch_size    = 64 * 1024;
+      static constexpr std::size_t max_registered = 8;
+
+      /**
+       * State shared with the background thread (and the signal handler).
+       **/
+      struct state
+      {
+         int                       _fd;
+         formater_ptr_t            _formater;
+         ring_buffer<std::string>  _ring;
+         std::mutex                _mutex;
+         std::condition_variable   _wake;
+         std::condition_variable   _flushed;
+         std::atomic<bool>         _sleeping{false};
+         std::atomic<bool>         _stop    {false};
+         std::atomic<std::size_t>  _pushed  {0};
+         std::atomic<std::size_t>  _written {0};
+         std::string               _batch;
+         std::atomic<std::size_t>  _pending {0};   // size of batch being written (for the signal handler)
+
+         state(int fd, const format& form, std::size_t capacity)
+            :  _fd      (fd)
+            ,  _formater(format::create(form))
+            ,  _ring    (capacity)
+         {
+            _batch.reserve(batch_size);
+         }
+
+         void wake()
+         {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _wake.notify_one();
+         }
+      };
+
+      std::unique_ptr<state> _state;
+      std::thread            _thread;
+
+      /**
+       * Write whole buffer to file descriptor. Only uses async-signal-safe calls.
+       **/
+      static void write_all(int fd, const char* data, std::size_t size)
+      {
+         while(size > 0)
+         {
+            auto n = ::write(fd, data, size);
+            if(n < 0)
+            {
+               if(errno == EINTR)
+               {
+                  continue;
+               }
+               return;
+            }
+            data += n;
+            size -= static_cast<std::size_t>(n);
+         }
+      }
+
+      static int duplicate(int fd)
+      {
+         int dup = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+         if(dup < 0)
+         {
+            throw std::runtime_error("cutee: async_writer could not duplicate file descriptor.");
+         }
+         return dup;
+      }
+
+      /**
+       * Background thread.
+       **/
+      static void consume(state& s)
+      {
+         std::string message;
+         std::size_t count = 0;
+
+         auto write_batch = [&s, &count]()
+         {
+            s._pending.store(s._batch.size(), std::memory_order_release);
+            write_all(s._fd, s._batch.data(), s._batch.size());
+            s._pending.store(0, std::memory_order_release);
+            s._batch.clear();
+            s._written.fetch_add(count, std::memory_order_release);
+            count = 0;
+            {
+               std::lock_guard<std::mutex> lock(s._mutex);
+            }
+            s._flushed.notify_all();
+         };
+
+         for(;;)
+         {
+            bool any = false;
+            while(s._ring.try_pop(message))
+            {
+               any = true;
+               s._formater->replace_into(message, s._batch);
+               ++count;
+               if(s._batch.size() >= batch_size)
+               {
+                  write_batch();
+               }
+            }
+            if(count)
+            {
+               write_batch();
+            }
+
+            if(!any)
+            {
+               if(s._stop.load(std::memory_order_acquire) && s._ring.empty())
+               {
+                  break;
+               }
+
+               // Producers notify when they see us sleeping. The fences pair with the one in 'write',
+               // so either the producer sees the flag or we see its message, and no push is missed.
+               std::unique_lock<std::mutex> lock(s._mutex);
+               s._sleeping.store(true);
+               std::atomic_thread_fence(std::memory_order_seq_cst);
+               s._wake.wait(lock, [&s]() { return !s._ring.empty() || s._stop.load(); });
+               s._sleeping.store(false);
+            }
+         }
+      }
+
+      /**
+       * Registered writers, for flushing on fatal signals.
+       **/
+      static std::atomic<state*>* registry()
+      {
+         static std::atomic<state*> writers[max_registered] = {};
+         return writers;
+      }
+
+      static constexpr int fatal_signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGTERM };
+
+      static struct sigaction* previous_actions()
+      {
+         static struct sigaction actions[std::size(fatal_signals)];
+         return actions;
+      }
+
+      /**
+       * Write pending output of a writer. Does not format (tags are stripped) or allocate.
+       **/
+      static void emergency_write(const state& s)
+      {
+         if(auto pending = s._pending.load(std::memory_order_acquire))
+         {
+            write_all(s._fd, s._batch.data(), pending);
+         }
+         s._ring.peek
+            (  [&s](const std::string& message)
+               {
+                  std::size_t pos = 0;
+                  while(pos < message.size())
+                  {
+                     auto open  = message.find("[/", pos);
+                     auto close = open == std::string::npos ? open : message.find(']', open);
+                     if(close == std::string::npos)
+                     {
+                        write_all(s._fd, message.data() + pos, message.size() - pos);
+                        break;
+                     }
+                     write_all(s._fd, message.data() + pos, open - pos);
+                     pos = close + 1;
+                  }
+               }
+            );
+      }
+
+      static void signal_handler(int sig)
+      {
+         static std::atomic<bool> handling{false};
+         if(!handling.exchange(true))
+         {
+            auto* writers = registry();
+            for(std::size_t i = 0; i < max_registered; ++i)
+            {
+               if(auto* s = writers[i].load())
+               {
+                  emergency_write(*s);
+               }
+            }
+         }
+
+         // Pass on to previous handler
+         for(std::size_t i = 0; i < std::size(fatal_signals); ++i)
+         {
+            if(fatal_signals[i] == sig)
+            {
+               sigaction(sig, &previous_actions()[i], nullptr);
+            }
+         }
+         raise(sig);
+      }
+
+      static void install_signal_handlers()
+      {
+         static std::once_flag installed;
+         std::call_once
+            (  installed
+            ,  []()
+               {
+                  struct sigaction action = {};
+                  action.sa_handler = &async_writer::signal_handler;
+                  sigemptyset(&action.sa_mask);
+                  action.sa_flags = SA_RESETHAND;
+                  for(std::size_t i = 0; i < std::size(fatal_signals); ++i)
+                  {
+                     sigaction(fatal_signals[i], &action, &previous_actions()[i]);
+                  }
+               }
+            );
+      }
+
+      void register_state()
+      {
+         install_signal_handlers();
+         auto* writers = registry();
+         for(std::size_t i = 0; i < max_registered; ++i)
+         {
+            state* expected = nullptr;
+            if(writers[i].compare_exchange_strong(expected, _state.get()))
+            {
+               return;
+            }
+         }
+      }
+
+      void unregister_state()
+      {
+         auto* writers = registry();
+         for(std::size_t i = 0; i < max_registered; ++i)
+         {
+            state* expected = _state.get();
+            writers[i].compare_exchange_strong(expected, nullptr);
+         }
+      }
+
+   public:
+      /**
+       * Create writer for file descriptor 'fd' (not closed by the writer),
+       * with room for 'capacity' messages before writers have to wait.
+       * The writer writes to a duplicate of 'fd', so it is not affected if 'fd' is later
+       * redirected (e.g. by output capture).
+       **/
+      async_writer(int fd, const format& form, std::size_t capacity = 1024)
+         :  _state(new state(duplicate(fd), form, capacity))
+      {
+         _thread = std::thread(&async_writer::consume, std::ref(*_state));
+         this->register_state();
+      }
+
+      async_writer(const async_writer&) = delete;
+      async_writer& operator=(const async_writer&) = delete;
+
+      ~async_writer()
+      {
+         _state->_stop.store(true, std::memory_order_release);
+         _state->wake();
+         _thread.join();
+         this->unregister_state();
+         ::close(_state->_fd);
+      }
+
+      /**
+       * Queue message. Waits while the buffer is full.
+       **/
+      void write(const std::string& msg) const override
+      {
+         std::string message(msg);
+         while(!_state->_ring.try_push(std::move(message)))
+         {
+            _state->wake();
+            std::this_thread::yield();
+         }
+         _state->_pushed.fetch_add(1, std::memory_order_release);
+         std::atomic_thread_fence(std::memory_order_seq_cst);
+         if(_state->_sleeping.load())
+         {
+            _state->wake();
+         }
+      }
+
+      /**
+       * Wait until all messages queued before the call have been written.
+       **/
+      void flush() const override
+      {
+         auto target = _state->_pushed.load(std::memory_order_acquire);
+         std::unique_lock<std::mutex> lock(_state->_mutex);
+         _state->_wake.notify_one();
+         _state->_flushed.wait
+            (  lock
+            ,  [this, target]() { return _state->_written.load(std::memory_order_acquire) >= target; }
+            );
+      }
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_HAVE_POSIX */
+
+#endif /* CUTEE_ASYNC_WRITER_HPP_INCLUDED */
@@ -0,0 +1,386 @@
+#pragma once
+#ifndef CUTEE_BASELINE_HPP_INCLUDED
+#define CUTEE_BASELINE_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <unordered_map>
+
+#include "statistics.hpp"
+#include "escape.hpp"
+#include "osutil.hpp"
+
+namespace cutee
+{
+
+/**
+ * Baseline of a performance test: statistics of the wall clock durations of its iterations (in seconds),
+ * and the samples themselves (at most 'max_samples', evenly spaced quantiles if there were more).
+ **/
+struct baseline_entry
+{
+   static constexpr std::size_t max_samples = 1000;
+
+   stats::summary      _summary;
+   std::vector<double> _samples;
+
+   //! Create entry from samples, reducing them to at most 'max_samples'.
+   static baseline_entry from_samples(const std::vector<double>& samples)
+   {
+      baseline_entry entry;
+      entry._summary = stats::summarize(samples);
+      if(samples.size() <= max_samples)
+      {
+         entry._samples = samples;
+      }
+      else
+      {
+         std::vector<double> sorted(samples);
+         std::sort(sorted.begin(), sorted.end());
+         entry._samples.reserve(max_samples);
+         for(std::size_t i = 0; i < max_samples; ++i)
+         {
+            entry._samples.emplace_back(stats::percentile(sorted, (double(i) + 0.5) / double(max_samples)));
+         }
+      }
+      return entry;
+   }
+};
+
+/**
+ * Result of comparing a performance test against its baseline.
+ **/
+struct baseline_comparison
+{
+   double           _baseline_median = 0.0;
+   double           _median          = 0.0;
+   double           _change          = 0.0;   // relative change of the median, positive is slower
+   stats::rank_test _test;                    // Mann-Whitney U, current slower than baseline
+   bool             _regression      = false; // significant and at least the minimum effect
+};
+
+/**
+ * Baselines of performance tests, keyed by test name.
+ *
+ * Stored on disk as JSON lines, one object per test, e.g.
+ *    {"name":"sum (performance)","count":100,"mean":1.2e-05,"median":...,"samples":[...]}
+ *
+ * Safe to use from several workers at once.
+ **/
+class baseline_store
+{
+   private:
+      std::unordered_map<std::string, baseline_entry> _entries;
+      mutable std::mutex _mutex;
+
+      //! Minimal reader for the lines written by 'save'.
+      class line_reader
+      {
+         private:
+            const std::string& _line;
+            std::size_t        _pos = 0;
+
+            void skip_space()
+            {
+               while(_pos < _line.size() && (_line[_pos] == ' ' || _line[_pos] == '\t'))
+               {
+                  ++_pos;
+               }
+            }
+
+         public:
+            explicit line_reader(const std::string& line)
+               :  _line(line)
+            {
+            }
+
+            bool consume(char c)
+            {
+               skip_space();
+               if(_pos < _line.size() && _line[_pos] == c)
+               {
+                  ++_pos;
+                  return true;
+               }
+               return false;
+            }
+
+            bool string(std::string& out)
+            {
+               if(!consume('"'))
+               {
+                  return false;
+               }
+               out.clear();
+               while(_pos < _line.size() && _line[_pos] != '"')
+               {
+                  char c = _line[_pos++];
+                  if(c == '\\' && _pos < _line.size())
+                  {
+                     char e = _line[_pos++];
+                     switch(e)
+                     {
+                        case 'n': c = '\n'; break;
+                        case 'r': c = '\r'; break;
+                        case 't': c = '\t'; break;
+                        case 'u':
+                           if(_pos + 4 > _line.size())
+                           {
+                              return false;
+                           }
+                           c = static_cast<char>(std::strtol(_line.substr(_pos, 4).c_str(), nullptr, 16));
+                           _pos += 4;
+                           break;
+                        default: c = e; break;
+                     }
+                  }
+                  out += c;
+               }
+               return consume('"');
+            }
+
+            bool number(double& out)
+            {
+               skip_space();
+               const char* begin = _line.c_str() + _pos;
+               char* end = nullptr;
+               out = std::strtod(begin, &end);
+               if(end == begin)
+               {
+                  return false;
+               }
+               _pos += static_cast<std::size_t>(end - begin);
+               return true;
+            }
+      };
+
+      static bool parse(const std::string& line, std::string& name, baseline_entry& entry)
+      {
+         line_reader reader(line);
+         if(!reader.consume('{'))
+         {
+            return false;
+         }
+         auto& s = entry._summary;
+         std::unordered_map<std::string, double*> fields
+            {  {"mean", &s._mean}, {"median", &s._median}, {"min", &s._min}, {"max", &s._max}
+            ,  {"stddev", &s._stddev}, {"mad", &s._mad}, {"p90", &s._p90}, {"p99", &s._p99}
+            ,  {"ci_low", &s._ci_low}, {"ci_high", &s._ci_high}
+            };
+         std::string key;
+         do
+         {
+            if(!reader.string(key) || !reader.consume(':'))
+            {
+               return false;
+            }
+            if(key == "name")
+            {
+               if(!reader.string(name)) return false;
+            }
+            else if(key == "samples")
+            {
+               if(!reader.consume('[')) return false;
+               double x;
+               while(reader.number(x))
+               {
+                  entry._samples.emplace_back(x);
+                  reader.consume(',');
+               }
+               if(!reader.consume(']')) return false;
+            }
+            else
+            {
+               double x;
+               if(!reader.number(x)) return false;
+               auto iter = fields.find(key);
+               if(iter != fields.end())
+               {
+                  *iter->second = x;
+               }
+               else if(key == "count")
+               {
+                  s._count = static_cast<std::size_t>(x);
+               }
+            }
+         }
+         while(reader.consume(','));
+         return reader.consume('}') && !name.empty();
+      }
+
+      static std::string format(const std::string& name, const baseline_entry& entry)
+      {
+         const auto& s = entry._summary;
+         std::string line = "{\"name\":";
+         detail::append_json_string(line, name);
+         line += ",\"count\":" + std::to_string(s._count);
+         const std::pair<const char*, double> fields[] =
+            {  {"mean", s._mean}, {"median", s._median}, {"min", s._min}, {"max", s._max}
+            ,  {"stddev", s._stddev}, {"mad", s._mad}, {"p90", s._p90}, {"p99", s._p99}
+            ,  {"ci_low", s._ci_low}, {"ci_high", s._ci_high}
+            };
+         for(const auto& field : fields)
+         {
+            line += ",\"";
+            line += field.first;
+            line += "\":";
+            detail::append_number(line, field.second);
+         }
+         line += ",\"samples\":[";
+         for(std::size_t i = 0; i < entry._samples.size(); ++i)
+         {
+            if(i)
+            {
+               line += ',';
+            }
+            detail::append_number(line, entry._samples[i]);
+         }
+         line += "]}";
+         return line;
+      }
+
+   public:
+      /**
+       * Load baselines from file. A missing or unreadable file gives no baselines, malformed lines are skipped.
+       **/
+      bool load(const std::string& path)
+      {
+         std::ifstream ifs(path);
+         if(!ifs)
+         {
+            return false;
+         }
+
+         std::lock_guard<std::mutex> lock(_mutex);
+         std::string line;
+         while(std::getline(ifs, line))
+         {
+            std::string name;
+            baseline_entry entry;
+            if(parse(line, name, entry))
+            {
+               _entries[name] = std::move(entry);
+            }
+         }
+         return true;
+      }
+
+      /**
+       * Save baselines to file, sorted by test name. Written to a uniquely named temporary file first and then renamed,
+       * so concurrent readers never see a partial file and concurrent writers do not mix their files.
+       **/
+      bool save(const std::string& path) const
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         auto tmp = detail::temporary_path(path);
+         {
+            std::ofstream ofs(tmp, std::ios::trunc);
+            if(!ofs)
+            {
+               return false;
+            }
+
+            std::vector<const std::pair<const std::string, baseline_entry>*> entries;
+            for(const auto& e : _entries)
+            {
+               entries.emplace_back(&e);
+            }
+            std::sort(entries.begin(), entries.end(), [](auto lhs, auto rhs) { return lhs->first < rhs->first; });
+
+            for(const auto* e : entries)
+            {
+               ofs << format(e->first, e->second) << "\n";
+            }
+            if(!ofs)
+            {
+               ofs.close();
+               std::remove(tmp.c_str());
+               return false;
+            }
+         }
+         if(std::rename(tmp.c_str(), path.c_str()) != 0)
+         {
+            std::remove(tmp.c_str());
+            return false;
+         }
+         return true;
+      }
+
+      /**
+       * Get copy of baseline of test. Returns false if test has no baseline.
+       **/
+      bool find(const std::string& name, baseline_entry& entry) const
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         auto iter = _entries.find(name);
+         if(iter == _entries.end())
+         {
+            return false;
+         }
+         entry = iter->second;
+         return true;
+      }
+
+      /**
+       * Record (replace) baseline of test.
+       **/
+      void record(const std::string& name, baseline_entry entry)
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _entries[name] = std::move(entry);
+      }
+
+      std::size_t size() const
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         return _entries.size();
+      }
+
+      /**
+       * Compare 'samples' against 'baseline'. A regression needs the samples to be slower by a
+       * Mann-Whitney U test at significance level 'alpha', and the median to be slower by at least 'min_effect'.
+       **/
+      static baseline_comparison compare(const baseline_entry& baseline, const std::vector<double>& samples, double alpha, double min_effect)
+      {
+         baseline_comparison result;
+         std::vector<double> sorted(samples);
+         std::sort(sorted.begin(), sorted.end());
+         result._baseline_median = baseline._summary._median;
+         result._median          = stats::percentile(sorted, 0.5);
+         result._change          = result._baseline_median > 0.0 ? result._median / result._baseline_median - 1.0 : 0.0;
+         result._test            = stats::mann_whitney_greater(samples, baseline._samples);
+         result._regression      = result._test._p < alpha && result._change >= min_effect;
+         return result;
+      }
+};
+
+namespace detail
+{
+
+/**
+ * Baseline settings of the current run. Set from run_options by the suite before tests are run.
+ **/
+struct baseline_settings
+{
+   baseline_store* _store      = nullptr;  // nullptr when not comparing or updating
+   bool            _update     = false;    // record baselines instead of comparing
+   double          _alpha      = 0.01;
+   double          _min_effect = 0.05;
+};
+
+inline baseline_settings& baselines()
+{
+   static baseline_settings settings;
+   return settings;
+}
+
+} /* namespace detail */
+
+} /* namespace cutee */
+
+#endif /* CUTEE_BASELINE_HPP_INCLUDED */
@@ -0,0 +1,467 @@
+#pragma once
+#ifndef CUTEE_BINARY_LOG_HPP_INCLUDED
+#define CUTEE_BINARY_LOG_HPP_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "typedef.hpp"
+#include "writer.hpp"
+#include "event.hpp"
+
+#ifdef CUTEE_HAVE_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* CUTEE_HAVE_POSIX */
+
+namespace cutee
+{
+
+/**
+ * Binary result log.
+ *
+ * The file starts with a 16 byte header (magic "CUTEELOG", version, record size) followed by entries,
+ * each an 8 byte entry header (tag, payload size) and a payload padded to 8 bytes. An entry is either
+ * a string, defining the next string id (ids start at 1, 0 is the empty string), or a fixed size record
+ * referring to strings by id. Strings are always defined before they are used, so the log can be appended
+ * to while running and read (memory mapped) in one pass. Numbers are in native byte order.
+ *
+ * Records of a test: one 'test' record, followed by a 'failure' record for each failure,
+ * each followed by a 'value' record for each of its values.
+ **/
+namespace binary_log
+{
+
+constexpr char          magic[8] = {'C', 'U', 'T', 'E', 'E', 'L', 'O', 'G'};
+constexpr std::uint32_t version  = 1;
+
+enum tag : std::uint32_t { string_tag = 1, record_tag = 2 };
+
+enum kind : std::uint32_t { suite_begin = 1, test = 2, failure = 3, value = 4, suite_end = 5 };
+
+struct file_header
+{
+   char          _magic[8];
+   std::uint32_t _version;
+   std::uint32_t _record_size;
+};
+
+struct entry_header
+{
+   std::uint32_t _tag;
+   std::uint32_t _size;
+};
+
+/**
+ * Fixed size record. Meaning of fields depends on kind:
+ *
+ *    suite_begin : _name = suite,   _count = tests to run
+ *    test        : _name = test,    _count = assertions, _failed, _duration, _text = output, _file = captured output
+ *    failure     : _name = message, _file, _line, _text = rendered failure
+ *    value       : _name = label,   _file = value, _text = type
+ *    suite_end   : _name = suite,   _count = tests, _count2 = assertions, _line = failed tests, _duration
+ **/
+struct record
+{
+   std::uint32_t _kind     = 0;
+   std::uint32_t _name     = 0;
+   std::uint32_t _file     = 0;
+   std::uint32_t _line     = 0;
+   std::uint64_t _count    = 0;
+   std::uint64_t _count2   = 0;
+   double        _duration = 0.0;
+   std::uint32_t _failed   = 0;
+   std::uint32_t _text     = 0;
+};
+
+static_assert(sizeof(record) == 48, "binary_log::record must have a fixed size.");
+
+inline std::uint32_t padded(std::uint32_t size)
+{
+   return (size + 7u) & ~7u;
+}
+
+} /* namespace binary_log */
+
+/**
+ * Writer appending results to a binary log file. Strings of bounded cardinality (names, files, messages,
+ * labels, types) are interned, so each distinct one is stored once. Per-test text (output, rendered failures
+ * and values) is written inline, defining a fresh string each time, so memory does not grow with the output.
+ **/
+class binary_log_writer
+   :  public writer
+{
+   private:
+      std::FILE*                                            _file = nullptr;
+      mutable std::unordered_map<std::string, std::uint32_t> _strings;      // interned strings
+      mutable std::uint32_t                                  _next_id = 1;  // id of next string defined
+
+      void write_bytes(const void* data, std::size_t size) const
+      {
+         if(std::fwrite(data, 1, size, _file) != size)
+         {
+            throw std::runtime_error("cutee: could not write binary log.");
+         }
+      }
+
+      void write_entry(binary_log::tag t, const void* data, std::uint32_t size) const
+      {
+         static const char zeros[8] = {};
+         binary_log::entry_header header{t, size};
+         this->write_bytes(&header, sizeof(header));
+         this->write_bytes(data, size);
+         this->write_bytes(zeros, binary_log::padded(size) - size);
+      }
+
+      //! Define string (not kept by the writer), returning its id.
+      std::uint32_t define(std::string_view str) const
+      {
+         if(str.empty())
+         {
+            return 0;
+         }
+         this->write_entry(binary_log::string_tag, str.data(), static_cast<std::uint32_t>(str.size()));
+         return _next_id++;
+      }
+
+      //! Define string once, returning the id of the first definition on later calls.
+      std::uint32_t intern(std::string_view str) const
+      {
+         if(str.empty())
+         {
+            return 0;
+         }
+         auto iter = _strings.find(std::string{str});
+         if(iter != _strings.end())
+         {
+            return iter->second;
+         }
+         auto id = this->define(str);
+         _strings.emplace(std::string{str}, id);
+         return id;
+      }
+
+      void write_record(const binary_log::record& r) const
+      {
+         this->write_entry(binary_log::record_tag, &r, sizeof(r));
+      }
+
+   public:
+      /**
+       * Open log file 'path', truncated unless 'append' is set. Strings are interned per writer,
+       * so a log appended to by several writers repeats strings, which readers handle.
+       **/
+      explicit binary_log_writer(const std::string& path, bool append = false)
+         :  _file(std::fopen(path.c_str(), append ? "ab" : "wb"))
+      {
+         if(!_file)
+         {
+            throw std::runtime_error("cutee: could not open binary log '" + path + "'.");
+         }
+         if(std::ftell(_file) == 0)
+         {
+            binary_log::file_header header{};
+            std::memcpy(header._magic, binary_log::magic, sizeof(header._magic));
+            header._version     = binary_log::version;
+            header._record_size = sizeof(binary_log::record);
+            this->write_bytes(&header, sizeof(header));
+         }
+      }
+
+      binary_log_writer(const binary_log_writer&) = delete;
+      binary_log_writer& operator=(const binary_log_writer&) = delete;
+
+      ~binary_log_writer()
+      {
+         std::fclose(_file);
+      }
+
+      //! Rendered text output is not used.
+      void write(const std::string&) const
+      {
+      }
+
+      void flush() const
+      {
+         std::fflush(_file);
+      }
+
+      void begin_suite(const suite_event& event) const
+      {
+         binary_log::record r;
+         r._kind  = binary_log::suite_begin;
+         r._name  = this->intern(event._name);
+         r._count = event._num_tests;
+         this->write_record(r);
+      }
+
+      void test_finished(const test_event& event) const
+      {
+         binary_log::record r;
+         r._kind     = binary_log::test;
+         r._name     = this->intern(event._name);
+         r._count    = event._num_assertions;
+         r._failed   = event._failed;
+         r._duration = event._duration;
+         r._text     = this->define(event._output);
+         r._file     = this->define(event._captured);
+         this->write_record(r);
+
+         for(const auto& f : event._failures)
+         {
+            binary_log::record fr;
+            fr._kind = binary_log::failure;
+            fr._name = this->intern(f._message);
+            fr._file = this->intern(f._file);
+            fr._line = static_cast<std::uint32_t>(f._line);
+            fr._text = this->define(f._text);
+            this->write_record(fr);
+
+            for(const auto& v : f._values)
+            {
+               binary_log::record vr;
+               vr._kind = binary_log::value;
+               vr._name = this->intern(v._label);
+               vr._file = this->define(v._value);
+               vr._text = this->intern(v._type);
+               this->write_record(vr);
+            }
+         }
+      }
+
+      void end_suite(const suite_summary& summary) const
+      {
+         binary_log::record r;
+         r._kind     = binary_log::suite_end;
+         r._name     = this->intern(summary._name);
+         r._count    = summary._num_tests;
+         r._count2   = summary._num_assertions;
+         r._line     = static_cast<std::uint32_t>(summary._num_failed);
+         r._duration = summary._duration;
+         this->write_record(r);
+      }
+};
+
+/**
+ * Reader of binary result logs. The file is memory mapped where possible,
+ * and only the offsets of strings are kept, so logs are read in one pass with little memory.
+ **/
+class binary_log_reader
+{
+   private:
+      const char*                    _data = nullptr;
+      std::size_t                    _size = 0;
+      std::vector<char>              _buffer;    // used if the file is not mapped
+      bool                           _mapped = false;
+      std::vector<std::string_view>  _strings;   // strings defined so far, by id - 1
+
+   public:
+      explicit binary_log_reader(const std::string& path)
+      {
+#ifdef CUTEE_HAVE_POSIX
+         int fd = ::open(path.c_str(), O_RDONLY);
+         if(fd < 0)
+         {
+            throw std::runtime_error("cutee: could not open binary log '" + path + "'.");
+         }
+         struct stat st;
+         if(::fstat(fd, &st) == 0 && st.st_size > 0)
+         {
+            void* data = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if(data != MAP_FAILED)
+            {
+               _data   = static_cast<const char*>(data);
+               _size   = static_cast<std::size_t>(st.st_size);
+               _mapped = true;
+               ::madvise(data, _size, MADV_SEQUENTIAL);
+            }
+         }
+         ::close(fd);
+#endif /* CUTEE_HAVE_POSIX */
+         if(!_mapped)
+         {
+            std::FILE* file = std::fopen(path.c_str(), "rb");
+            if(!file)
+            {
+               throw std::runtime_error("cutee: could not open binary log '" + path + "'.");
+            }
+            char chunk[65536];
+            std::size_t n;
+            while((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+            {
+               _buffer.insert(_buffer.end(), chunk, chunk + n);
+            }
+            std::fclose(file);
+            _data = _buffer.data();
+            _size = _buffer.size();
+         }
+
+         binary_log::file_header header;
+         if(_size < sizeof(header))
+         {
+            throw std::runtime_error("cutee: '" + path + "' is not a binary log.");
+         }
+         std::memcpy(&header, _data, sizeof(header));
+         if(std::memcmp(header._magic, binary_log::magic, sizeof(header._magic)) != 0 || header._version != binary_log::version || header._record_size != sizeof(binary_log::record))
+         {
+            throw std::runtime_error("cutee: '" + path + "' is not a supported binary log.");
+         }
+      }
+
+      binary_log_reader(const binary_log_reader&) = delete;
+      binary_log_reader& operator=(const binary_log_reader&) = delete;
+
+      ~binary_log_reader()
+      {
+#ifdef CUTEE_HAVE_POSIX
+         if(_mapped)
+         {
+            ::munmap(const_cast<char*>(_data), _size);
+         }
+#endif /* CUTEE_HAVE_POSIX */
+      }
+
+      /**
+       * Get string by id (valid while the reader lives). Only strings defined before the current record are known.
+       **/
+      std::string_view string(std::uint32_t id) const
+      {
+         return (id == 0 || id > _strings.size()) ? std::string_view{} : _strings[id - 1];
+      }
+
+      /**
+       * Call 'f(record)' for each record in the log, in order. A log appended to by
+       * several writers restarts string ids at each file header it contains.
+       **/
+      template<class F>
+      void for_each_record(F&& f)
+      {
+         _strings.clear();
+         std::size_t pos = sizeof(binary_log::file_header);
+         while(pos + sizeof(binary_log::entry_header) <= _size)
+         {
+            // Appended log
+            if(std::memcmp(_data + pos, binary_log::magic, sizeof(binary_log::magic)) == 0)
+            {
+               _strings.clear();
+               pos += sizeof(binary_log::file_header);
+               continue;
+            }
+
+            binary_log::entry_header header;
+            std::memcpy(&header, _data + pos, sizeof(header));
+            pos += sizeof(header);
+            if(pos + header._size > _size)
+            {
+               break; // truncated (e.g. writer crashed)
+            }
+
+            if(header._tag == binary_log::string_tag)
+            {
+               _strings.emplace_back(_data + pos, header._size);
+            }
+            else if(header._tag == binary_log::record_tag && header._size == sizeof(binary_log::record))
+            {
+               binary_log::record r;
+               std::memcpy(&r, _data + pos, sizeof(r));
+               f(static_cast<const binary_log::record&>(r));
+            }
+            pos += binary_log::padded(header._size);
+         }
+      }
+
+      /**
+       * Replay the log as structured events to a writer (e.g. junit_writer).
+       * Tests are passed on one at a time, for which 'select(event)' returns true
+       * ('select' may also modify the event, e.g. to drop failures).
+       **/
+      template<class Select>
+      void replay(const writer& w, Select&& select)
+      {
+         test_event event;
+         bool       have_test = false;
+
+         auto finish = [&]()
+         {
+            if(have_test && select(event))
+            {
+               w.test_finished(event);
+            }
+            have_test = false;
+            event     = test_event{};
+         };
+
+         this->for_each_record
+            (  [&](const binary_log::record& r)
+               {
+                  switch(r._kind)
+                  {
+                     case binary_log::suite_begin:
+                        finish();
+                        w.begin_suite(suite_event{std::string{this->string(r._name)}, static_cast<std::size_t>(r._count)});
+                        break;
+                     case binary_log::test:
+                        finish();
+                        have_test              = true;
+                        event._name            = this->string(r._name);
+                        event._num_assertions  = static_cast<std::size_t>(r._count);
+                        event._failed          = r._failed != 0;
+                        event._duration        = r._duration;
+                        event._output          = this->string(r._text);
+                        event._captured        = this->string(r._file);
+                        break;
+                     case binary_log::failure:
+                        event._failures.emplace_back
+                           (  failure_event
+                              {  std::string{this->string(r._name)}
+                              ,  std::string{this->string(r._file)}
+                              ,  static_cast<int>(r._line)
+                              ,  {}
+                              ,  std::string{this->string(r._text)}
+                              }
+                           );
+                        break;
+                     case binary_log::value:
+                        if(!event._failures.empty())
+                        {
+                           event._failures.back()._values.emplace_back
+                              (  failure_event::value
+                                 {  std::string{this->string(r._name)}
+                                 ,  std::string{this->string(r._file)}
+                                 ,  std::string{this->string(r._text)}
+                                 }
+                              );
+                        }
+                        break;
+                     case binary_log::suite_end:
+                        finish();
+                        w.end_suite
+                           (  suite_summary
+                              {  std::string{this->string(r._name)}
+                              ,  static_cast<std::size_t>(r._count)
+                              ,  static_cast<std::size_t>(r._count2)
+                              ,  static_cast<std::size_t>(r._line)
+                              ,  r._duration
+                              }
+                           );
+                        break;
+                     default:
+                        break;
+                  }
+               }
+            );
+         finish();
+      }
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_BINARY_LOG_HPP_INCLUDED */
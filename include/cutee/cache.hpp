@@ -0,0 +1,137 @@
+#pragma once
+#ifndef CUTEE_CACHE_HPP_INCLUDED
+#define CUTEE_CACHE_HPP_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <exception>
+
+namespace cutee
+{
+
+namespace cache
+{
+
+//! Assumed cache line size in bytes.
+constexpr std::size_t line_size = 64;
+
+//! Size used when the last level cache size cannot be read from the system.
+constexpr std::size_t fallback_size = 32 * 1024 * 1024;
+
+namespace detail
+{
+
+/**
+ * Parse a sysfs cache size such as "48K", "2048K" or "32M". Returns 0 on failure.
+ **/
+inline std::size_t parse_size(const std::string& str)
+{
+   std::size_t pos  = 0;
+   std::size_t size = 0;
+   try
+   {
+      size = std::stoul(str, &pos);
+   }
+   catch(const std::exception&)
+   {
+      return 0;
+   }
+   if(pos < str.size())
+   {
+      switch(str[pos])
+      {
+         case 'K': size *= 1024; break;
+         case 'M': size *= 1024 * 1024; break;
+         case 'G': size *= 1024 * 1024 * 1024; break;
+         default: break;
+      }
+   }
+   return size;
+}
+
+} /* namespace detail */
+
+/**
+ * Size in bytes of the last level (highest level, largest) data or unified cache of cpu0,
+ * read once from /sys/devices/system/cpu/cpu0/cache. Falls back to 'fallback_size'.
+ **/
+inline std::size_t last_level_size()
+{
+   static const std::size_t size = []()
+   {
+      int         best_level = 0;
+      std::size_t best_size  = 0;
+      for(int index = 0; ; ++index)
+      {
+         std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+         std::ifstream level_file(dir + "level");
+         if(!level_file)
+         {
+            break;
+         }
+         int level = 0;
+         std::string type, size_str;
+         level_file >> level;
+         std::ifstream(dir + "type") >> type;
+         std::ifstream(dir + "size") >> size_str;
+         if(type == "Instruction")
+         {
+            continue;
+         }
+         auto bytes = detail::parse_size(size_str);
+         if(level > best_level || (level == best_level && bytes > best_size))
+         {
+            best_level = level;
+            best_size  = bytes;
+         }
+      }
+      return best_size ? best_size : fallback_size;
+   }();
+   return size;
+}
+
+/**
+ * Evicts the CPU caches of the calling thread by streaming (reading and writing each line of)
+ * a buffer 1.5 times the size of the last level cache. The buffer is allocated on first use, per thread.
+ **/
+class evictor
+{
+   private:
+      std::vector<unsigned char> _buffer;
+
+   public:
+      evictor()
+         :  _buffer(last_level_size() + last_level_size() / 2, 1)
+      {
+      }
+
+      //! Size of the streamed buffer in bytes.
+      std::size_t size() const
+      {
+         return _buffer.size();
+      }
+
+      void evict()
+      {
+         volatile unsigned char* data = _buffer.data();
+         for(std::size_t i = 0; i < _buffer.size(); i += line_size)
+         {
+            data[i] = static_cast<unsigned char>(data[i] + 1);
+         }
+      }
+
+      //! Evictor of the calling thread.
+      static evictor& get()
+      {
+         static thread_local evictor instance;
+         return instance;
+      }
+};
+
+} /* namespace cache */
+
+} /* namespace cutee */
+
+#endif /* CUTEE_CACHE_HPP_INCLUDED */
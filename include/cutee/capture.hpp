@@ -0,0 +1,367 @@
+#pragma once
+#ifndef CUTEE_CAPTURE_HPP_INCLUDED
+#define CUTEE_CAPTURE_HPP_INCLUDED
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <streambuf>
+#include <iostream>
+#include <stdexcept>
+
+#include "typedef.hpp"
+#include "alloc.hpp"
+
+#ifdef CUTEE_HAVE_POSIX
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif /* __linux__ */
+#endif /* CUTEE_HAVE_POSIX */
+
+namespace cutee
+{
+namespace detail
+{
+
+/**
+ * Capture buffer of the calling thread, written to by capture_streambuf while active.
+ * Captures nest (a test run from a running test, e.g. in a collection): each has a frame with its start
+ * in the buffer, and output is kept only by the innermost one.
+ **/
+struct capture_target
+{
+   struct frame
+   {
+      std::size_t _start;     // start of the capture in the buffer
+      std::size_t _dropped;   // bytes dropped by the capture
+   };
+
+   bool               _active  = false;
+   std::string        _buffer;
+   std::size_t        _limit   = 0;
+   std::size_t        _start   = 0;
+   std::size_t        _dropped = 0;
+   std::vector<frame> _outer;     // suspended enclosing captures
+
+   void append(const char* s, std::size_t n)
+   {
+      auto used = _buffer.size() - _start;
+      auto room = _limit > used ? _limit - used : 0;
+      auto take = n < room ? n : room;
+      _buffer.append(s, take);
+      _dropped += n - take;
+   }
+};
+
+inline capture_target& current_capture_target()
+{
+   static Cutee_thread_local capture_target target;
+   return target;
+}
+
+/**
+ * Stream buffer routing output to the capture buffer of the writing thread if it is capturing,
+ * and to the original stream buffer otherwise. It is unbuffered, so output from different threads is never mixed.
+ **/
+class capture_streambuf
+   :  public std::streambuf
+{
+   private:
+      std::streambuf* _original;
+
+   protected:
+      int_type overflow(int_type c) override
+      {
+         if(traits_type::eq_int_type(c, traits_type::eof()))
+         {
+            return traits_type::not_eof(c);
+         }
+         char ch = traits_type::to_char_type(c);
+         return this->xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+      }
+
+      std::streamsize xsputn(const char* s, std::streamsize n) override
+      {
+         auto& target = current_capture_target();
+         if(target._active)
+         {
+            alloc::suspend framework;
+            target.append(s, static_cast<std::size_t>(n));
+            return n;
+         }
+         return _original->sputn(s, n);
+      }
+
+      int sync() override
+      {
+         return current_capture_target()._active ? 0 : _original->pubsync();
+      }
+
+   public:
+      explicit capture_streambuf(std::streambuf* original)
+         :  _original(original)
+      {
+      }
+
+      std::streambuf* original() const
+      {
+         return _original;
+      }
+};
+
+} /* namespace detail */
+
+/**
+ * Captures what tests write to stdout and stderr, so it can be shown only for failed tests.
+ *
+ * With 'redirect_fds' (only one worker) file descriptors 1 and 2 are redirected into an in-memory file
+ * (memfd on Linux, otherwise a temporary file), which captures everything, including printf and child processes.
+ * File descriptors are shared by all threads, so with several workers std::cout, std::cerr and std::clog are
+ * routed to a buffer of the thread running the test instead, and output written directly to the
+ * file descriptors (e.g. printf) is not captured.
+ *
+ * At most 'limit' bytes are kept per test.
+ **/
+class output_capture
+{
+   private:
+      std::size_t                _limit;
+      bool                       _redirect = false;
+      int                        _file     = -1;
+      std::FILE*                 _tmpfile  = nullptr;
+      int                        _saved[2] = {-1, -1};
+      std::vector<std::size_t>   _starts;   // start offsets of the nested captures (file descriptor redirection)
+      detail::capture_streambuf  _cout;
+      detail::capture_streambuf  _cerr;
+      detail::capture_streambuf  _clog;
+
+      static void flush_all()
+      {
+         std::cout.flush();
+         std::cerr.flush();
+         std::clog.flush();
+         std::fflush(nullptr);
+      }
+
+      /**
+       * Describe captured output, or return empty string if nothing was written.
+       **/
+      static std::string describe(std::string&& text, std::size_t dropped, std::size_t limit)
+      {
+         if(text.empty() && dropped == 0)
+         {
+            return std::string{};
+         }
+         if(!text.empty() && text.back() != '\n')
+         {
+            text += '\n';
+         }
+         if(dropped)
+         {
+            text += "... " + std::to_string(dropped) + " more bytes not captured (limit " + std::to_string(limit) + ")\n";
+         }
+         return std::move(text);
+      }
+
+   public:
+      output_capture(bool redirect_fds, std::size_t limit)
+         :  _limit(limit)
+         ,  _cout (std::cout.rdbuf())
+         ,  _cerr (std::cerr.rdbuf())
+         ,  _clog (std::clog.rdbuf())
+      {
+#ifdef CUTEE_HAVE_POSIX
+         if(redirect_fds)
+         {
+#ifdef __linux__
+            _file = ::memfd_create("cutee-capture", MFD_CLOEXEC);
+#endif /* __linux__ */
+            if(_file < 0 && (_tmpfile = std::tmpfile()))
+            {
+               _file = ::fileno(_tmpfile);
+            }
+            _redirect = _file >= 0;
+         }
+#endif /* CUTEE_HAVE_POSIX */
+         if(!_redirect)
+         {
+            std::cout.rdbuf(&_cout);
+            std::cerr.rdbuf(&_cerr);
+            std::clog.rdbuf(&_clog);
+         }
+      }
+
+      output_capture(const output_capture&) = delete;
+      output_capture& operator=(const output_capture&) = delete;
+
+      ~output_capture()
+      {
+         if(_redirect)
+         {
+#ifdef CUTEE_HAVE_POSIX
+            if(_tmpfile)
+            {
+               std::fclose(_tmpfile);
+            }
+            else
+            {
+               ::close(_file);
+            }
+#endif /* CUTEE_HAVE_POSIX */
+         }
+         else
+         {
+            std::cout.rdbuf(_cout.original());
+            std::cerr.rdbuf(_cerr.original());
+            std::clog.rdbuf(_clog.original());
+         }
+      }
+
+      /**
+       * Start capturing output of the calling thread (or of the process when redirecting file descriptors).
+       * May be nested (a collection runs its tests from within a test): only the outermost 'begin' redirects,
+       * and a nested capture takes the output until its 'end', which is then not part of the enclosing capture.
+       **/
+      void begin()
+      {
+#ifdef CUTEE_HAVE_POSIX
+         if(_redirect)
+         {
+            flush_all();
+            if(_starts.empty())
+            {
+               _saved[0] = ::dup(1);
+               _saved[1] = ::dup(2);
+               ::dup2(_file, 1);
+               ::dup2(_file, 2);
+            }
+            _starts.emplace_back(static_cast<std::size_t>(::lseek(_file, 0, SEEK_CUR)));
+            return;
+         }
+#endif /* CUTEE_HAVE_POSIX */
+         auto& target = detail::current_capture_target();
+         if(target._active)
+         {
+            target._outer.emplace_back(detail::capture_target::frame{target._start, target._dropped});
+            target._start = target._buffer.size();
+         }
+         else
+         {
+            target._buffer.clear();
+            target._start = 0;
+         }
+         target._limit   = _limit;
+         target._dropped = 0;
+         target._active  = true;
+      }
+
+      /**
+       * Stop capturing and get what was captured since the matching 'begin'.
+       * The outermost 'end' restores the original output.
+       **/
+      std::string end()
+      {
+#ifdef CUTEE_HAVE_POSIX
+         if(_redirect)
+         {
+            if(_starts.empty())
+            {
+               return std::string{};
+            }
+            flush_all();
+            auto start = _starts.back();
+            _starts.pop_back();
+            if(_starts.empty())
+            {
+               ::dup2(_saved[0], 1);
+               ::dup2(_saved[1], 2);
+               ::close(_saved[0]);
+               ::close(_saved[1]);
+               _saved[0] = _saved[1] = -1;
+            }
+
+            auto size = static_cast<std::size_t>(::lseek(_file, 0, SEEK_CUR)) - start;
+            auto keep = size < _limit ? size : _limit;
+            std::string text(keep, '\0');
+            std::size_t pos = 0;
+            while(pos < keep)
+            {
+               auto n = ::pread(_file, &text[pos], keep - pos, static_cast<off_t>(start + pos));
+               if(n <= 0)
+               {
+                  break;
+               }
+               pos += static_cast<std::size_t>(n);
+            }
+            text.resize(pos);
+            if(::ftruncate(_file, static_cast<off_t>(start)) == 0)
+            {
+               ::lseek(_file, static_cast<off_t>(start), SEEK_SET);
+            }
+            return describe(std::move(text), size - keep, _limit);
+         }
+#endif /* CUTEE_HAVE_POSIX */
+         auto& target = detail::current_capture_target();
+         if(!target._active)
+         {
+            return std::string{};
+         }
+         auto text = describe(target._buffer.substr(target._start), target._dropped, _limit);
+         target._buffer.resize(target._start);
+         if(target._outer.empty())
+         {
+            target._active = false;
+         }
+         else
+         {
+            target._start   = target._outer.back()._start;
+            target._dropped = target._outer.back()._dropped;
+            target._outer.pop_back();
+         }
+         return text;
+      }
+
+      /**
+       * Captures for the lifetime of the scope (also when left by an exception).
+       **/
+      class scope
+      {
+         private:
+            output_capture* _capture;
+
+         public:
+            explicit scope(output_capture* capture)
+               :  _capture(capture)
+            {
+               if(_capture)
+               {
+                  _capture->begin();
+               }
+            }
+
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+
+            ~scope()
+            {
+               this->end();
+            }
+
+            //! Stop capturing. Returns what was captured (empty if not capturing).
+            std::string end()
+            {
+               std::string text;
+               if(_capture)
+               {
+                  text = _capture->end();
+                  _capture = nullptr;
+               }
+               return text;
+            }
+      };
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_CAPTURE_HPP_INCLUDED */
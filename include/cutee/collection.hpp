@@ -24,7 +24,8 @@ class collection
       {
          for(decltype(test_size()) i=0; i<test_size(); ++i)
          {
-            asserter::_suite_ptr->run_test(*(this->get_test(i)));
+            test_ptr_t holder;
+            asserter::_suite_ptr->run_test(this->acquire_test(i, holder), this->test_name(i));
          }
       }
       
@@ -34,7 +35,7 @@ class collection
          std::stringstream sstr;
          for(decltype(test_size()) i=0; i<test_size(); ++i)
          {
-            sstr << "\n         " << const_cast<collection*>(this)->get_test(i)->name();
+            sstr << "\n         " << this->test_name(i);
          }
          return sstr.str();
       }
@@ -3,7 +3,13 @@
 #define CUTEE_CONTAINER_HPP_INCLUDED
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <tuple>
+#include <memory>
+#include <unordered_set>
+#include <initializer_list>
+#include <type_traits>
 
 #include "test.hpp"
 #include "function.hpp"
@@ -12,16 +18,166 @@
 namespace cutee
 {
 
+/**
+ * Interface for creating a registered test when it is needed.
+ **/
+struct test_factory
+{
+   virtual ~test_factory() = default;
+   virtual test_ptr_t create() = 0;
+};
+
+namespace detail
+{
+
+/**
+ * Factory holding a creator function and copies of the registration arguments.
+ * Arguments given as (const) lvalues are passed to the test as lvalues of the copy,
+ * other arguments as a fresh copy. Non-const lvalues are never copied (see 'lazy_constructible_v').
+ **/
+template<class Create, class... Args>
+struct test_factory_impl
+   :  public test_factory
+{
+   Create                            _create;
+   std::tuple<std::decay_t<Args>...> _args;
+
+   template<class C, class... As>
+   test_factory_impl(C&& create, As&&... args)
+      :  _create(std::forward<C>(create))
+      ,  _args(std::forward<As>(args)...)
+   {
+   }
+
+   template<class A, class S>
+   static decltype(auto) replay(S& stored)
+   {
+      if constexpr(std::is_lvalue_reference_v<A>)
+      {
+         return static_cast<S&>(stored);
+      }
+      else
+      {
+         return S(stored);
+      }
+   }
+
+   template<std::size_t... I>
+   test_ptr_t create_internal(std::index_sequence<I...>)
+   {
+      return _create(replay<Args>(std::get<I>(_args))...);
+   }
+
+   test_ptr_t create() override
+   {
+      return create_internal(std::index_sequence_for<Args...>{});
+   }
+};
+
+/**
+ * Can a test be created later from copies of the registration arguments.
+ * Not if an argument cannot be copied, or is a non-const lvalue, which the test may take by
+ * reference ('X&') and then expects to be the caller's object, not a copy.
+ **/
+template<class Arg>
+constexpr bool lazy_argument_v
+   =  std::is_copy_constructible_v<std::decay_t<Arg> >
+   && !(std::is_lvalue_reference_v<Arg> && !std::is_const_v<std::remove_reference_t<Arg> >)
+   ;
+
+template<class... Args>
+constexpr bool lazy_constructible_v = (lazy_argument_v<Args> && ...);
+
+} /* namespace detail */
+
 //
 class container
 {
+   public:
+      using factory_ptr_t = std::unique_ptr<test_factory>;
+
+      /**
+       * Registered test. Name and tags are interned in the container.
+       **/
+      struct entry
+      {
+         std::string_view              _name;
+         std::vector<std::string_view> _tags;
+         factory_ptr_t                 _factory;
+         test_ptr_t                    _test;    // instance kept alive (eagerly created or requested by get_test)
+         bool                          _performance = false;
+      };
+
+      /**
+       * Handle for a registered test, used for adding tags.
+       **/
+      class registration
+      {
+         private:
+            container*  _container;
+            std::size_t _index;
+
+         public:
+            registration(container* c, std::size_t index)
+               :  _container(c)
+               ,  _index(index)
+            {
+            }
+
+            registration& tag(const std::string& t)
+            {
+               _container->m_tests[_index]._tags.emplace_back(_container->intern(t));
+               return *this;
+            }
+
+            registration& tags(std::initializer_list<std::string> ts)
+            {
+               for(const auto& t : ts)
+               {
+                  this->tag(t);
+               }
+               return *this;
+            }
+      };
+
    private:
-      using test_container_t = std::vector<test_ptr_t>;
-      
+      using test_container_t = std::vector<entry>;
+
       //
-      test_container_t m_tests;
-   
+      test_container_t                m_tests;
+      std::unordered_set<std::string> m_strings; // interned names and tags (node based, so views stay valid)
+
+      std::string_view intern(const std::string& str)
+      {
+         return *m_strings.insert(str).first;
+      }
+
+      //
+      // register test with creator function called with (copies of) args when the test is needed.
+      // Tests with arguments that cannot be copied, or are non-const lvalues, are created right away.
+      //
+      template<class Create, class... Args>
+      registration register_test(const std::string& a_name, Create&& create, Args&&... args)
+      {
+         entry e;
+         e._name = intern(a_name);
+         if constexpr(detail::lazy_constructible_v<Args...>)
+         {
+            e._factory = factory_ptr_t{ new detail::test_factory_impl<std::decay_t<Create>, Args&&...>(std::forward<Create>(create), std::forward<Args>(args)...) };
+         }
+         else
+         {
+            e._test = create(std::forward<Args>(args)...);
+         }
+         m_tests.emplace_back(std::move(e));
+         return registration{this, m_tests.size() - 1};
+      }
+
    public:
+      container() = default;
+      container(container&&) = default;
+      container& operator=(container&&) = default;
+
       // virtual destructor
       virtual ~container() = default;
 
@@ -29,77 +185,153 @@ class container
       // add tests (T is test class type) with name defaulted to default-name
       //
       template<class T>
-      void add_test(const std::string a_name=default_test_name::acquire_name())
-      { 
-         //m_tests.push_back(unit_test_factory<T>(a_name)); 
-         m_tests.push_back(test_create<T>(a_name)); 
+      registration add_test(const std::string a_name=default_test_name::acquire_name())
+      {
+         return this->register_test(a_name, [a_name]() { return test_create<T>(a_name); });
       }
-      
+
       //
       // add test with extra arguments
       //
       template<class T, typename... Args>
-      void add_test(const std::string& a_name, Args&&... args)
-      { 
-         //m_tests.push_back(unit_test_factory<T>(a_name, std::forward<Args>(args)...)); 
-         m_tests.push_back(test_create<T>(a_name, std::forward<Args>(args)...)); 
+      registration add_test(const std::string& a_name, Args&&... args)
+      {
+         return this->register_test
+            (  a_name
+            ,  [a_name](auto&&... as) { return test_create<T>(a_name, std::forward<decltype(as)>(as)...); }
+            ,  std::forward<Args>(args)...
+            );
       }
-      
+
       //
       // add test with extra arguments
       //
       template<class T, typename... Args>
-      void add(Args&&... args)
-      { 
-         this->add_test<T>(std::forward<Args>(args)...);
+      registration add(Args&&... args)
+      {
+         return this->add_test<T>(std::forward<Args>(args)...);
       }
 
       template<class... Args>
-      void add_function(const std::string& a_name, Args&&... args)
+      registration add_function(const std::string& a_name, Args&&... args)
       {
-         this->add_test<function_wrap<Args...> >(a_name, std::forward<Args>(args)...);
+         return this->add_test<function_wrap<Args...> >(a_name, std::forward<Args>(args)...);
       }
-      
+
       //
       // add performance tests (N is num runs, T is test class type)
       //
       template<class T, class... Args>
-      void add_performance(const std::string& a_name, int ntimes, Args&&... args)
-      { 
-         m_tests.push_back(create_performance_test<T>(ntimes, a_name, std::forward<Args>(args)...)); 
+      registration add_performance(const std::string& a_name, int ntimes, Args&&... args)
+      {
+         auto reg = this->register_test
+            (  a_name + " (performance)"
+            ,  [a_name, ntimes](auto&&... as) { return create_performance_test<T>(ntimes, a_name, std::forward<decltype(as)>(as)...); }
+            ,  std::forward<Args>(args)...
+            );
+         m_tests.back()._performance = true;
+         return reg;
       }
-      
+
+      //
+      // add performance tests with fixed or adaptive number of runs (T is test class type)
+      //
+      template<class T, class... Args>
+      registration add_performance(const std::string& a_name, const performance_options& options, Args&&... args)
+      {
+         auto reg = this->register_test
+            (  a_name + " (performance)"
+            ,  [a_name, options](auto&&... as) { return create_performance_test<T>(options, a_name, std::forward<decltype(as)>(as)...); }
+            ,  std::forward<Args>(args)...
+            );
+         m_tests.back()._performance = true;
+         return reg;
+      }
+
       //
       // add performance tests (N is num runs, T is test class type)
       //
       template<class... Args>
-      void add_performance_function(const std::string& a_name, int ntimes, Args&&... args)
+      registration add_performance_function(const std::string& a_name, int ntimes, Args&&... args)
       {
-         this->add_performance<function_wrap<Args...> >(a_name, ntimes, std::forward<Args>(args)...);
+         return this->add_performance<function_wrap<Args...> >(a_name, ntimes, std::forward<Args>(args)...);
       }
 
       //
-      // get test number i
+      // add performance tests with fixed or adaptive number of runs
+      //
+      template<class... Args>
+      registration add_performance_function(const std::string& a_name, const performance_options& options, Args&&... args)
+      {
+         return this->add_performance<function_wrap<Args...> >(a_name, options, std::forward<Args>(args)...);
+      }
+
+      //
+      // get test number i (the test is created if needed and kept alive by the container)
       //
       test_ptr_t& get_test(int i)
-      { 
-         return m_tests[i]; 
+      {
+         auto& e = m_tests[i];
+         if(!e._test)
+         {
+            e._test = e._factory->create();
+         }
+         return e._test;
+      }
+
+      //
+      // get test number i for running. Uses the instance kept in the container if any,
+      // otherwise a new instance is created in 'holder', and destroyed when the caller drops it.
+      //
+      test_interface& acquire_test(std::size_t i, test_ptr_t& holder)
+      {
+         auto& e = m_tests[i];
+         if(e._test)
+         {
+            return *e._test;
+         }
+         holder = e._factory->create();
+         return *holder;
       }
-      
+
+      //
+      // get name of test number i (without creating the test)
+      //
+      std::string_view test_name(std::size_t i) const
+      {
+         return m_tests[i]._name;
+      }
+
+      //
+      // get tags of test number i (without creating the test)
+      //
+      const std::vector<std::string_view>& test_tags(std::size_t i) const
+      {
+         return m_tests[i]._tags;
+      }
+
+      //
+      // check if test number i is a performance test (without creating the test)
+      //
+      bool is_performance_test(std::size_t i) const
+      {
+         return m_tests[i]._performance;
+      }
+
       //
       // get number of tests
       //
-      auto test_size() const 
-      { 
-         return m_tests.size(); 
+      auto test_size() const
+      {
+         return m_tests.size();
       }
-      
+
       //
       // get number of tests
       //
-      auto size() const 
-      { 
-         return m_tests.size(); 
+      auto size() const
+      {
+         return m_tests.size();
       }
 };
 
@@ -0,0 +1,425 @@
+#pragma once
+#ifndef CUTEE_DIFF_HPP_INCLUDED
+#define CUTEE_DIFF_HPP_INCLUDED
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+namespace cutee
+{
+
+namespace diff
+{
+
+//! Edit operation: element(s) in both sequences, only in the second ('insert') or only in the first ('erase').
+enum class op : char { equal, insert, erase };
+
+/**
+ * Run of 'length' operations, starting at index '_lhs' of the first and '_rhs' of the second sequence.
+ **/
+struct edit
+{
+   op          _op;
+   std::size_t _lhs;
+   std::size_t _rhs;
+   std::size_t _length;
+};
+
+/**
+ * Cutoffs. The diff is given up (and callers fall back to reporting the first difference)
+ * if what is left after removing the common prefix and suffix is larger than '_max_size' elements
+ * in total, if more than '_max_edits' edits are needed, or if it takes longer than '_max_seconds'.
+ **/
+struct options
+{
+   std::size_t _max_size    = 1 << 16;
+   std::size_t _max_edits   = 1024;
+   double      _max_seconds = 0.1;
+};
+
+namespace detail
+{
+
+/**
+ * Myers' O((N+M)D) diff in linear space: the middle snake of the edit graph is found
+ * by searching forwards and backwards at the same time, and the parts before and after it
+ * are diffed recursively. The result is the path through the edit graph, as a list of points.
+ **/
+template<class Eq>
+class myers
+{
+   private:
+      using index_t = long long;
+      using clock   = std::chrono::steady_clock;
+
+      struct point
+      {
+         index_t _x;
+         index_t _y;
+      };
+
+      Eq&                  _eq;
+      const options&       _opts;
+      clock::time_point    _deadline;
+      std::vector<index_t> _vf;
+      std::vector<index_t> _vb;
+      bool                 _aborted = false;
+
+      /**
+       * Find middle snake of box [left, right) x [top, bottom). Returns false if the box is empty or the search was given up.
+       **/
+      bool midpoint(index_t left, index_t top, index_t right, index_t bottom, point& start, point& finish)
+      {
+         auto width  = right - left;
+         auto height = bottom - top;
+         auto size   = width + height;
+         if(size == 0)
+         {
+            return false;
+         }
+         auto delta = width - height;
+         auto max   = (size + 1) / 2;
+
+         // Diagonals k in [-max - 1, max + 1]
+         _vf.assign(static_cast<std::size_t>(2 * max + 3), 0);
+         _vb.assign(static_cast<std::size_t>(2 * max + 3), 0);
+         auto vf = [this, max](index_t k) -> index_t& { return _vf[static_cast<std::size_t>(k + max + 1)]; };
+         auto vb = [this, max](index_t k) -> index_t& { return _vb[static_cast<std::size_t>(k + max + 1)]; };
+         vf(1) = left;
+         vb(1) = bottom;
+
+         for(index_t d = 0; d <= max; ++d)
+         {
+            if(static_cast<std::size_t>(d) > _opts._max_edits || (_opts._max_seconds > 0 && clock::now() > _deadline))
+            {
+               _aborted = true;
+               return false;
+            }
+
+            // Forwards
+            for(index_t k = d; k >= -d; k -= 2)
+            {
+               index_t px, x;
+               if(k == -d || (k != d && vf(k - 1) < vf(k + 1)))
+               {
+                  px = x = vf(k + 1);
+               }
+               else
+               {
+                  px = vf(k - 1);
+                  x  = px + 1;
+               }
+               index_t y  = top + (x - left) - k;
+               index_t py = (d == 0 || x != px) ? y : y - 1;
+               while(x < right && y < bottom && _eq(static_cast<std::size_t>(x), static_cast<std::size_t>(y)))
+               {
+                  ++x;
+                  ++y;
+               }
+               vf(k) = x;
+
+               auto c = k - delta;
+               if((delta & 1) && c >= -(d - 1) && c <= d - 1 && y >= vb(c))
+               {
+                  start  = point{px, py};
+                  finish = point{x, y};
+                  return true;
+               }
+            }
+
+            // Backwards
+            for(index_t c = d; c >= -d; c -= 2)
+            {
+               index_t py, y;
+               if(c == -d || (c != d && vb(c - 1) > vb(c + 1)))
+               {
+                  py = y = vb(c + 1);
+               }
+               else
+               {
+                  py = vb(c - 1);
+                  y  = py - 1;
+               }
+               auto    k  = c + delta;
+               index_t x  = left + (y - top) + k;
+               index_t px = (d == 0 || y != py) ? x : x + 1;
+               while(x > left && y > top && _eq(static_cast<std::size_t>(x - 1), static_cast<std::size_t>(y - 1)))
+               {
+                  --x;
+                  --y;
+               }
+               vb(c) = y;
+
+               if(!(delta & 1) && k >= -d && k <= d && x <= vf(k))
+               {
+                  start  = point{x, y};
+                  finish = point{px, py};
+                  return true;
+               }
+            }
+         }
+         return false;
+      }
+
+      bool find_path(index_t left, index_t top, index_t right, index_t bottom, std::vector<point>& path)
+      {
+         point start, finish;
+         if(!this->midpoint(left, top, right, bottom, start, finish))
+         {
+            return false;
+         }
+         if(!this->find_path(left, top, start._x, start._y, path) && !_aborted)
+         {
+            path.emplace_back(start);
+         }
+         if(!_aborted && !this->find_path(finish._x, finish._y, right, bottom, path) && !_aborted)
+         {
+            path.emplace_back(finish);
+         }
+         return true;
+      }
+
+      static void add(std::vector<edit>& script, op o, std::size_t lhs, std::size_t rhs, std::size_t length)
+      {
+         if(length == 0)
+         {
+            return;
+         }
+         if(!script.empty() && script.back()._op == o)
+         {
+            script.back()._length += length;
+         }
+         else
+         {
+            script.emplace_back(edit{o, lhs, rhs, length});
+         }
+      }
+
+   public:
+      myers(Eq& eq, const options& opts)
+         :  _eq      (eq)
+         ,  _opts    (opts)
+         ,  _deadline(clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(opts._max_seconds)))
+      {
+      }
+
+      /**
+       * Diff [begin, n) of the first with [begin, m) of the second sequence, appending to 'script'.
+       **/
+      bool run(std::size_t begin, std::size_t n, std::size_t m, std::vector<edit>& script)
+      {
+         std::vector<point> path;
+         if(!this->find_path(static_cast<index_t>(begin), static_cast<index_t>(begin), static_cast<index_t>(n), static_cast<index_t>(m), path))
+         {
+            return !_aborted;
+         }
+         if(_aborted)
+         {
+            return false;
+         }
+
+         // Walk the path: each step is a diagonal, one insert or erase, and a diagonal
+         auto diagonal = [&](index_t& x, index_t& y, const point& to)
+         {
+            auto x0 = x;
+            while(x < to._x && y < to._y && _eq(static_cast<std::size_t>(x), static_cast<std::size_t>(y)))
+            {
+               ++x;
+               ++y;
+            }
+            add(script, op::equal, static_cast<std::size_t>(x0), static_cast<std::size_t>(y - (x - x0)), static_cast<std::size_t>(x - x0));
+         };
+         for(std::size_t i = 0; i + 1 < path.size(); ++i)
+         {
+            auto x = path[i]._x;
+            auto y = path[i]._y;
+            const auto& to = path[i + 1];
+            diagonal(x, y, to);
+            if(to._x - x < to._y - y)
+            {
+               add(script, op::insert, static_cast<std::size_t>(x), static_cast<std::size_t>(y), 1);
+               ++y;
+            }
+            else if(to._x - x > to._y - y)
+            {
+               add(script, op::erase, static_cast<std::size_t>(x), static_cast<std::size_t>(y), 1);
+               ++x;
+            }
+            diagonal(x, y, to);
+         }
+         return true;
+      }
+};
+
+} /* namespace detail */
+
+/**
+ * Compute shortest edit script turning a sequence of 'n' elements into one of 'm' elements,
+ * where 'eq(i, j)' compares element 'i' of the first with element 'j' of the second.
+ * Returns false if a cutoff was hit, leaving 'script' unspecified.
+ **/
+template<class Eq>
+bool compute(std::size_t n, std::size_t m, Eq&& eq, std::vector<edit>& script, const options& opts = options{})
+{
+   script.clear();
+
+   // Common prefix and suffix are cheap, and are all there is to most failures
+   std::size_t prefix = 0;
+   while(prefix < n && prefix < m && eq(prefix, prefix))
+   {
+      ++prefix;
+   }
+   std::size_t suffix = 0;
+   while(suffix < n - prefix && suffix < m - prefix && eq(n - suffix - 1, m - suffix - 1))
+   {
+      ++suffix;
+   }
+   if((n - prefix - suffix) + (m - prefix - suffix) > opts._max_size)
+   {
+      return false;
+   }
+
+   if(prefix)
+   {
+      script.emplace_back(edit{op::equal, 0, 0, prefix});
+   }
+
+   // Diff what is left in between
+   std::vector<edit> middle;
+   detail::myers<std::remove_reference_t<Eq> > engine(eq, opts);
+   if(!engine.run(prefix, n - suffix, m - suffix, middle))
+   {
+      return false;
+   }
+   for(const auto& e : middle)
+   {
+      if(!script.empty() && script.back()._op == e._op)
+      {
+         script.back()._length += e._length;
+      }
+      else
+      {
+         script.emplace_back(e);
+      }
+   }
+
+   if(suffix)
+   {
+      if(!script.empty() && script.back()._op == op::equal)
+      {
+         script.back()._length += suffix;
+      }
+      else
+      {
+         script.emplace_back(edit{op::equal, n - suffix, m - suffix, suffix});
+      }
+   }
+   return true;
+}
+
+/**
+ * Render edit script as hunks, in the style of a unified diff, with 'context' unchanged elements around changes:
+ *
+ *    @@ -first,count +first,count @@
+ *      unchanged
+ *    - only in first
+ *    + only in second
+ *
+ * 'lhs(i)' and 'rhs(j)' render single elements. Output stops after about 'max_bytes' (0 for no limit).
+ * Positions in hunk headers are counted from 'base' (1 for lines, as in diff(1)).
+ **/
+template<class L, class R>
+std::string render_hunks(const std::vector<edit>& script, L&& lhs, R&& rhs, std::size_t context = 3, std::size_t max_bytes = 0, std::size_t base = 1)
+{
+   std::string result;
+   auto full = [&result, max_bytes]() { return max_bytes && result.size() >= max_bytes; };
+
+   std::size_t i = 0;
+   while(i < script.size() && !full())
+   {
+      // Find next change, and extend the hunk while changes are at most 2 * context unchanged elements apart
+      while(i < script.size() && script[i]._op == op::equal)
+      {
+         ++i;
+      }
+      if(i == script.size())
+      {
+         break;
+      }
+      auto first = i;
+      auto last  = i;
+      for(;;)
+      {
+         if(last + 1 < script.size() && script[last + 1]._op != op::equal)
+         {
+            ++last;
+         }
+         else if(last + 2 < script.size() && script[last + 1]._length <= 2 * context)
+         {
+            last += 2;
+         }
+         else
+         {
+            break;
+         }
+      }
+
+      // Context before and after
+      std::size_t before = (first > 0) ? std::min(context, script[first - 1]._length) : 0;
+      std::size_t after  = (last + 1 < script.size()) ? std::min(context, script[last + 1]._length) : 0;
+
+      auto lhs_begin = script[first]._lhs - before;
+      auto rhs_begin = script[first]._rhs - before;
+      std::size_t lhs_count = before + after;
+      std::size_t rhs_count = before + after;
+      for(auto j = first; j <= last; ++j)
+      {
+         lhs_count += (script[j]._op != op::insert) ? script[j]._length : 0;
+         rhs_count += (script[j]._op != op::erase)  ? script[j]._length : 0;
+      }
+
+      result += "@@ -" + std::to_string(lhs_begin + base) + "," + std::to_string(lhs_count)
+             +  " +"  + std::to_string(rhs_begin + base) + "," + std::to_string(rhs_count) + " @@\n";
+
+      for(std::size_t k = 0; k < before && !full(); ++k)
+      {
+         result += "  " + lhs(lhs_begin + k) + "\n";
+      }
+      for(auto j = first; j <= last && !full(); ++j)
+      {
+         const auto& e = script[j];
+         for(std::size_t k = 0; k < e._length && !full(); ++k)
+         {
+            switch(e._op)
+            {
+               case op::equal:  result += "  " + lhs(e._lhs + k) + "\n"; break;
+               case op::erase:  result += "- " + lhs(e._lhs + k) + "\n"; break;
+               case op::insert: result += "+ " + rhs(e._rhs + k) + "\n"; break;
+            }
+         }
+      }
+      for(std::size_t k = 0; k < after && !full(); ++k)
+      {
+         result += "  " + lhs(script[last + 1]._lhs + k) + "\n";
+      }
+
+      i = last + 1;
+   }
+
+   if(full())
+   {
+      result += "... (truncated)\n";
+   }
+   return result;
+}
+
+} /* namespace diff */
+
+} /* namespace cutee */
+
+#endif /* CUTEE_DIFF_HPP_INCLUDED */
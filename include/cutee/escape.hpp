@@ -0,0 +1,82 @@
+#pragma once
+#ifndef CUTEE_ESCAPE_HPP_INCLUDED
+#define CUTEE_ESCAPE_HPP_INCLUDED
+
+#include <string>
+#include <string_view>
+#include <cstdio>
+
+namespace cutee
+{
+namespace detail
+{
+
+/**
+ * Append 'str' as a quoted JSON string (also valid as a YAML scalar).
+ **/
+inline void append_json_string(std::string& out, std::string_view str)
+{
+   out += '"';
+   for(char c : str)
+   {
+      switch(c)
+      {
+         case '"' : out += "\\\""; break;
+         case '\\': out += "\\\\"; break;
+         case '\n': out += "\\n";  break;
+         case '\r': out += "\\r";  break;
+         case '\t': out += "\\t";  break;
+         default:
+            if(static_cast<unsigned char>(c) < 0x20)
+            {
+               char buf[8];
+               std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(static_cast<unsigned char>(c)));
+               out += buf;
+            }
+            else
+            {
+               out += c;
+            }
+      }
+   }
+   out += '"';
+}
+
+/**
+ * Append 'str' escaped for XML text and attribute values.
+ * Control characters not allowed in XML 1.0 are replaced by '?'.
+ **/
+inline void append_xml_escaped(std::string& out, std::string_view str)
+{
+   for(char c : str)
+   {
+      switch(c)
+      {
+         case '&' : out += "&amp;";  break;
+         case '<' : out += "&lt;";   break;
+         case '>' : out += "&gt;";   break;
+         case '"' : out += "&quot;"; break;
+         case '\'': out += "&apos;"; break;
+         case '\n':
+         case '\r':
+         case '\t': out += c; break;
+         default:
+            out += (static_cast<unsigned char>(c) < 0x20) ? '?' : c;
+      }
+   }
+}
+
+/**
+ * Append number with enough digits to round trip.
+ **/
+inline void append_number(std::string& out, double value)
+{
+   char buf[32];
+   std::snprintf(buf, sizeof(buf), "%.9g", value);
+   out += buf;
+}
+
+} /* namespace detail */
+} /* namespace cutee */
+
+#endif /* CUTEE_ESCAPE_HPP_INCLUDED */
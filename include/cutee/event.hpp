@@ -0,0 +1,72 @@
+#pragma once
+#ifndef CUTEE_EVENT_HPP_INCLUDED
+#define CUTEE_EVENT_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "alloc.hpp"
+
+namespace cutee
+{
+
+/**
+ * A single failure of a test (failed assertion or exception).
+ **/
+struct failure_event
+{
+   //! Value involved in a failed assertion, e.g. { "expected", "2", "int" }.
+   struct value
+   {
+      std::string _label;
+      std::string _value;
+      std::string _type;
+   };
+
+   std::string        _message;   // assertion message (or exception description)
+   std::string        _file;      // empty if unknown
+   int                _line = 0;
+   std::vector<value> _values;
+   std::string        _text;      // failure as rendered in the text output
+};
+
+/**
+ * Result of a single test, passed to writers when the test has finished.
+ **/
+struct test_event
+{
+   std::string                _name;
+   double                     _duration       = 0.0;   // seconds, including setup and teardown
+   std::size_t                _num_assertions = 0;
+   bool                       _failed         = false;
+   std::string                _output;                 // custom message of the test (e.g. performance results)
+   std::string                _captured;               // captured stdout/stderr (only for failed tests)
+   alloc::counters            _allocations;            // heap allocations in setup and run (if counted, see alloc.hpp)
+   std::vector<failure_event> _failures;
+};
+
+/**
+ * Start of a suite run.
+ **/
+struct suite_event
+{
+   std::string _name;
+   std::size_t _num_tests = 0;
+};
+
+/**
+ * End of a suite run.
+ **/
+struct suite_summary
+{
+   std::string _name;
+   std::size_t _num_tests      = 0;
+   std::size_t _num_assertions = 0;
+   std::size_t _num_failed     = 0;
+   double      _duration       = 0.0;   // seconds
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_EVENT_HPP_INCLUDED */
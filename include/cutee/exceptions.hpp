@@ -6,6 +6,7 @@
 
 #include "assertion.hpp"
 #include "message.hpp"
+#include "event.hpp"
 
 namespace cutee
 {
@@ -29,29 +30,44 @@ inline failed::~failed() noexcept { }
 struct assertion_failed
    :  public failed
 {
-   std::string _what;
+   failure_event _failure;
    
    template<class... Ts>
-   static std::string construct_what__
+   assertion_failed
       (  const assertion<Ts...>& asrt
       )
+      :  _failure(message::describe(asrt))
    {
-      return message::generate(asrt);
    }
-   
-   template<class... Ts>
-   assertion_failed
-      (  const assertion<Ts...>& asrt
+
+   ~assertion_failed() = default;
+
+   const char* what() const noexcept override
+   {
+      return _failure._text.c_str();
+   }
+};
+
+/**
+ * Performance test significantly slower than its baseline
+ **/
+struct performance_regression
+   :  public failed
+{
+   std::string _text;
+
+   explicit performance_regression
+      (  std::string text
       )
-      :  _what(construct_what__(asrt))
+      :  _text(std::move(text))
    {
    }
 
-   ~assertion_failed() = default;
+   ~performance_regression() = default;
 
    const char* what() const noexcept override
    {
-      return _what.c_str();
+      return _text.c_str();
    }
 };
 
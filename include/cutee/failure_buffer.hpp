@@ -0,0 +1,366 @@
+#pragma once
+#ifndef CUTEE_FAILURE_BUFFER_HPP_INCLUDED
+#define CUTEE_FAILURE_BUFFER_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+
+#include "meta.hpp"
+#include "assertion.hpp"
+#include "message.hpp"
+#include "event.hpp"
+
+namespace cutee
+{
+
+namespace detail
+{
+
+/**
+ * Type used for keeping a copy of an assertion argument until the end of the test.
+ * Character arrays are kept as strings and other arrays as vectors,
+ * so the copy does not refer to storage that may be gone when it is formatted.
+ **/
+template<class T, class = void>
+struct stored_value
+{
+   using type = remove_cvref_t<T>;
+
+   template<class U>
+   static type store(U&& u)
+   {
+      return type(std::forward<U>(u));
+   }
+};
+
+template<class T>
+struct stored_value<T, std::enable_if_t<std::is_array_v<remove_cvref_t<T> > > >
+{
+   using element_type = std::remove_cv_t<std::remove_extent_t<remove_cvref_t<T> > >;
+   using type = std::conditional_t
+      <  std::is_same_v<element_type, char>
+      ,  std::string
+      ,  std::vector<element_type>
+      >;
+
+   template<class U>
+   static type store(const U& u)
+   {
+      if constexpr(std::is_same_v<element_type, char>)
+      {
+         return type(u);
+      }
+      else
+      {
+         return type(std::begin(u), std::end(u));
+      }
+   }
+};
+
+template<class T>
+using stored_value_t = typename stored_value<T>::type;
+
+/**
+ * Max size in bytes of an assertion argument that is copied for formatting after the test.
+ **/
+constexpr std::size_t max_deferred_bytes = 256;
+
+/**
+ * Check if an assertion argument is cheap to keep until the end of the test:
+ * a small trivially copyable value, or a short string or range of trivially copyable elements.
+ * Other arguments (not copyable, large or of unknown cost) are formatted (bounded) when the assertion fails.
+ **/
+template<class T>
+bool is_deferrable(const T& t)
+{
+   using type = stored_value_t<T>;
+   if constexpr(!std::is_copy_constructible_v<type>)
+   {
+      return false;
+   }
+   else if constexpr(std::is_trivially_copyable_v<type>)
+   {
+      return sizeof(type) <= max_deferred_bytes;
+   }
+   else if constexpr(is_sized_range_v<T>)
+   {
+      if constexpr(std::is_trivially_copyable_v<sized_range_value_t<T> >)
+      {
+         return static_cast<std::size_t>(std::size(t)) * sizeof(sized_range_value_t<T>) <= max_deferred_bytes;
+      }
+      else
+      {
+         return false;
+      }
+   }
+   else
+   {
+      return false;
+   }
+}
+
+} /* namespace detail */
+
+/**
+ * Buffer of failed soft assertions of the running test.
+ *
+ * Failed assertions with arguments cheap to copy are copied into an arena, and only described ('collect') or formatted ('format')
+ * when the test has finished. Other failures are described when they happen and the (bounded) description is kept instead.
+ * The arena blocks are kept between tests, so a worker only allocates when a test has more
+ * failures than any test before it. At most 'max' failures are kept, later ones are only counted.
+ **/
+class failure_buffer
+{
+   private:
+      static constexpr std::size_t block_size = 64 * 1024;
+
+      struct record
+      {
+         void*         _object;
+         failure_event (*_describe)(const void*);
+         void        (*_destroy)(void*);
+         record*       _next;
+      };
+
+      struct block
+      {
+         std::unique_ptr<std::byte[]> _data;
+         std::size_t                  _size;
+      };
+
+      std::vector<block> _blocks;
+      std::size_t        _block  = 0;   // current block
+      std::size_t        _offset = 0;   // offset into current block
+      record*            _head   = nullptr;
+      record*            _tail   = nullptr;
+      std::size_t        _count  = 0;   // number of failures (including dropped)
+      std::size_t        _max    = 0;   // max number of failures kept, 0 for no limit
+
+      void* allocate(std::size_t size, std::size_t align)
+      {
+         while(_block < _blocks.size())
+         {
+            auto& b = _blocks[_block];
+            // Align the address, blocks are only aligned for fundamental types
+            auto base = reinterpret_cast<std::uintptr_t>(b._data.get());
+            std::size_t offset = static_cast<std::size_t>(((base + _offset + align - 1) & ~static_cast<std::uintptr_t>(align - 1)) - base);
+            if(offset + size <= b._size)
+            {
+               _offset = offset + size;
+               return b._data.get() + offset;
+            }
+            ++_block;
+            _offset = 0;
+         }
+         std::size_t bsize = std::max(block_size, size + align);
+         _blocks.emplace_back(block{std::unique_ptr<std::byte[]>(new std::byte[bsize]), bsize});
+         _block  = _blocks.size() - 1;
+         _offset = 0;
+         return this->allocate(size, align);
+      }
+
+      template<class T>
+      T* construct(T&& t)
+      {
+         using type = std::decay_t<T>;
+         return new (this->allocate(sizeof(type), alignof(type))) type(std::forward<T>(t));
+      }
+
+      /**
+       * Link a kept failure (anything convertible to a failure_event) into the list.
+       **/
+      template<class T>
+      void push(T* object)
+      {
+         auto* rec = this->construct
+            (  record
+               {  object
+               ,  [](const void* o) { return failure_event(*static_cast<const T*>(o)); }
+               ,  [](void* o) { static_cast<T*>(o)->~T(); }
+               ,  nullptr
+               }
+            );
+         (_tail ? _tail->_next : _head) = rec;
+         _tail = rec;
+      }
+
+      /**
+       * Assertion with copied arguments, described when the failures are collected.
+       **/
+      template<class... Ts>
+      struct deferred
+      {
+         assertion<Ts...> _assertion;
+
+         operator failure_event() const
+         {
+            return message::describe(_assertion);
+         }
+      };
+
+   public:
+      failure_buffer() = default;
+      failure_buffer(const failure_buffer&) = delete;
+      failure_buffer& operator=(const failure_buffer&) = delete;
+
+      failure_buffer(failure_buffer&& other)
+         :  _blocks(std::move(other._blocks))
+         ,  _block (std::exchange(other._block,  0))
+         ,  _offset(std::exchange(other._offset, 0))
+         ,  _head  (std::exchange(other._head,   nullptr))
+         ,  _tail  (std::exchange(other._tail,   nullptr))
+         ,  _count (std::exchange(other._count,  0))
+         ,  _max   (other._max)
+      {
+         other._blocks.clear();
+      }
+
+      ~failure_buffer()
+      {
+         this->clear();
+      }
+
+      /**
+       * Set max number of failures kept (0 for no limit).
+       **/
+      void set_max(std::size_t max)
+      {
+         _max = max;
+      }
+
+      std::size_t max() const
+      {
+         return _max;
+      }
+
+      /**
+       * Count a failure without keeping it, if 'max' failures are kept already.
+       * Returns false (counting nothing) if the failure is to be kept, i.e. passed to 'add'.
+       * Lets callers skip creating the info of a failure that is dropped anyway.
+       **/
+      bool drop()
+      {
+         if(_max && _count >= _max)
+         {
+            ++_count;
+            return true;
+         }
+         return false;
+      }
+
+      /**
+       * Record a failed assertion. Arguments cheap to copy are copied into the buffer and formatted later,
+       * otherwise the failure is described (bounded by the rendering limits) right away.
+       **/
+      template<class... Ts>
+      void add(info&& i, Ts&&... ts)
+      {
+         ++_count;
+         if(_max && _count > _max)
+         {
+            return;
+         }
+
+         if((detail::is_deferrable(ts) && ...))
+         {
+            if constexpr((std::is_copy_constructible_v<detail::stored_value_t<Ts> > && ...))
+            {
+               using deferred_t = deferred<detail::stored_value_t<Ts>...>;
+               this->push
+                  (  this->construct
+                     (  deferred_t
+                        {  {  std::tuple<detail::stored_value_t<Ts>...>(detail::stored_value<Ts>::store(std::forward<Ts>(ts))...)
+                           ,  std::move(i)
+                           }
+                        }
+                     )
+                  );
+               return;
+            }
+         }
+         this->push
+            (  this->construct
+               (  message::describe
+                  (  assertion<Ts...>
+                     {  std::forward_as_tuple(std::forward<Ts>(ts)...)
+                     ,  std::move(i)
+                     }
+                  )
+               )
+            );
+      }
+
+      /**
+       * Number of failures recorded (including those not kept).
+       **/
+      std::size_t size() const
+      {
+         return _count;
+      }
+
+      bool empty() const
+      {
+         return _count == 0;
+      }
+
+      /**
+       * Describe all kept failures, followed by a note on the failures not kept (if any).
+       **/
+      void collect(std::vector<failure_event>& failures) const
+      {
+         for(auto* rec = _head; rec; rec = rec->_next)
+         {
+            failures.emplace_back(rec->_describe(rec->_object));
+         }
+         if(_max && _count > _max)
+         {
+            failure_event dropped;
+            dropped._message = "... " + std::to_string(_count - _max) + " more failures not recorded (max " + std::to_string(_max) + ")";
+            dropped._text    = "   " + dropped._message + "\n";
+            failures.emplace_back(std::move(dropped));
+         }
+      }
+
+      /**
+       * Format all kept failures into one message.
+       **/
+      std::string format() const
+      {
+         std::vector<failure_event> failures;
+         this->collect(failures);
+         std::string result;
+         for(std::size_t i = 0; i < failures.size(); ++i)
+         {
+            result += (i ? "\n" : "") + failures[i]._text;
+         }
+         return result;
+      }
+
+      /**
+       * Destroy recorded failures, keeping the memory for the next test.
+       **/
+      void clear()
+      {
+         for(auto* rec = _head; rec; rec = rec->_next)
+         {
+            rec->_destroy(rec->_object);
+         }
+         _head   = nullptr;
+         _tail   = nullptr;
+         _count  = 0;
+         _block  = 0;
+         _offset = 0;
+      }
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_FAILURE_BUFFER_HPP_INCLUDED */
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef CUTEE_FAILURE_QUEUE_HPP_INCLUDED
+#define CUTEE_FAILURE_QUEUE_HPP_INCLUDED
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <iterator>
+
+#include "event.hpp"
+
+namespace cutee
+{
+
+/**
+ * Lock-free multi-producer single-consumer queue of failures.
+ *
+ * Producers push onto an intrusive stack with compare-and-swap. The consumer takes the
+ * whole stack at once with 'drain', which returns the messages in push order.
+ * As nodes are never popped one at a time, there is no ABA problem.
+ **/
+class failure_queue
+{
+   private:
+      struct node
+      {
+         failure_event _failure;
+         node*         _next;
+      };
+
+      std::atomic<node*> _head{nullptr};
+
+   public:
+      failure_queue() = default;
+      failure_queue(const failure_queue&) = delete;
+      failure_queue& operator=(const failure_queue&) = delete;
+
+      ~failure_queue()
+      {
+         this->drain();
+      }
+
+      /**
+       * Push failure. Can be called from any thread.
+       **/
+      void push(failure_event&& failure)
+      {
+         auto* n = new node{std::move(failure), _head.load(std::memory_order_relaxed)};
+         while(!_head.compare_exchange_weak(n->_next, n, std::memory_order_release, std::memory_order_relaxed))
+         {
+         }
+      }
+
+      /**
+       * Take all failures pushed so far, oldest first.
+       **/
+      std::vector<failure_event> drain()
+      {
+         std::vector<failure_event> failures;
+         node* n = _head.exchange(nullptr, std::memory_order_acquire);
+         while(n)
+         {
+            failures.emplace_back(std::move(n->_failure));
+            node* next = n->_next;
+            delete n;
+            n = next;
+         }
+         return std::vector<failure_event>(std::make_move_iterator(failures.rbegin()), std::make_move_iterator(failures.rend()));
+      }
+
+      bool empty() const
+      {
+         return _head.load(std::memory_order_relaxed) == nullptr;
+      }
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_FAILURE_QUEUE_HPP_INCLUDED */
@@ -0,0 +1,133 @@
+#pragma once
+#ifndef CUTEE_FILTER_HPP_INCLUDED
+#define CUTEE_FILTER_HPP_INCLUDED
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <regex>
+#include <algorithm>
+
+namespace cutee
+{
+
+namespace detail
+{
+
+/**
+ * Match string against glob pattern, where '*' matches any sequence of characters
+ * and '?' matches any single character. Iterative with single backtrack point,
+ * so linear in the common case.
+ **/
+inline bool glob_match(std::string_view pattern, std::string_view str)
+{
+   std::size_t p = 0, s = 0;
+   std::size_t star = std::string_view::npos, mark = 0;
+   while(s < str.size())
+   {
+      if(p < pattern.size() && (pattern[p] == '?' || pattern[p] == str[s]))
+      {
+         ++p;
+         ++s;
+      }
+      else if(p < pattern.size() && pattern[p] == '*')
+      {
+         star = p++;
+         mark = s;
+      }
+      else if(star != std::string_view::npos)
+      {
+         p = star + 1;
+         s = ++mark;
+      }
+      else
+      {
+         return false;
+      }
+   }
+   while(p < pattern.size() && pattern[p] == '*')
+   {
+      ++p;
+   }
+   return p == pattern.size();
+}
+
+} /* namespace detail */
+
+/**
+ * Filter for selecting tests by name and tags.
+ *
+ * A test is accepted if its name matches any of the glob patterns (or there are none),
+ * its name matches the regular expression (if given), it has any of the required tags
+ * (or none are required), and it has none of the excluded tags.
+ **/
+class test_filter
+{
+   private:
+      std::vector<std::string> _globs;
+      std::vector<std::string> _tags;
+      std::vector<std::string> _exclude_tags;
+      bool                     _has_regex = false;
+      std::regex               _regex;
+
+      static bool contains(const std::vector<std::string_view>& tags, const std::string& tag)
+      {
+         return std::find(tags.begin(), tags.end(), tag) != tags.end();
+      }
+
+   public:
+      test_filter
+         (  std::vector<std::string> globs        = {}
+         ,  const std::string&       regex        = ""
+         ,  std::vector<std::string> tags         = {}
+         ,  std::vector<std::string> exclude_tags = {}
+         )
+         :  _globs       (std::move(globs))
+         ,  _tags        (std::move(tags))
+         ,  _exclude_tags(std::move(exclude_tags))
+         ,  _has_regex   (!regex.empty())
+      {
+         if(_has_regex)
+         {
+            _regex = std::regex(regex, std::regex::ECMAScript | std::regex::optimize);
+         }
+      }
+
+      /**
+       * Does filter accept everything.
+       **/
+      bool empty() const
+      {
+         return _globs.empty() && !_has_regex && _tags.empty() && _exclude_tags.empty();
+      }
+
+      /**
+       * Check whether test with name and tags is accepted by the filter.
+       **/
+      bool accepts(std::string_view name, const std::vector<std::string_view>& tags) const
+      {
+         for(const auto& tag : _exclude_tags)
+         {
+            if(contains(tags, tag))
+            {
+               return false;
+            }
+         }
+
+         if(!_tags.empty() && std::none_of(_tags.begin(), _tags.end(), [&tags](const auto& tag) { return contains(tags, tag); }))
+         {
+            return false;
+         }
+
+         if(!_globs.empty() && std::none_of(_globs.begin(), _globs.end(), [name](const auto& glob) { return detail::glob_match(glob, name); }))
+         {
+            return false;
+         }
+
+         return !_has_regex || std::regex_search(name.begin(), name.end(), _regex);
+      }
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_FILTER_HPP_INCLUDED */
@@ -4,9 +4,17 @@
 
 #include <limits>
 #include <complex>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <ostream>
+#include <string>
 #include <type_traits> 
 // std::is_floating_point
 // std::conditional_t
+
+#include "meta.hpp"
+#include "float_eq_simd.hpp"
  
 namespace cutee
 {
@@ -208,25 +216,219 @@ bool float_eq(const std::complex<T>& a_lhs, const std::complex<T>& a_rhs, const
          && float_eq(a_lhs.imag(), a_rhs.imag(), max_ulps_diff);
 }
 
+/********************************/
+// float equal (for contiguous ranges, e.g. std::vector, std::array, C arrays, spans)
+/********************************/
 template
-   <  class T
-   ,  typename std::enable_if_t<std::is_floating_point_v<T> >* = nullptr
+   <  class L
+   ,  class R
+   ,  typename std::enable_if_t
+      <  is_float_range_v<L> 
+      && is_float_range_v<R> 
+      && std::is_same_v<contiguous_range_value_t<L>, contiguous_range_value_t<R> >
+      >* = nullptr
    >
 bool float_eq
-   (  const std::vector<T>& a_lhs
-   ,  const std::vector<T>& a_rhs
-   ,  const integer_type<T> max_ulps_diff = 2
+   (  const L& a_lhs
+   ,  const R& a_rhs
+   ,  const integer_type<contiguous_range_value_t<L> > max_ulps_diff = 2
+   )
+{
+   using T = contiguous_range_value_t<L>;
+
+   const std::size_t size = std::size(a_lhs);
+   if(size != static_cast<std::size_t>(std::size(a_rhs)))
+   {
+      return false;
+   }
+
+   const T* lhs = std::data(a_lhs);
+   const T* rhs = std::data(a_rhs);
+   if constexpr(has_ulp_kernel_v<T>)
+   {
+      return ulp_equal(lhs, rhs, size, max_ulps_diff);
+   }
+   else
+   {
+      for(std::size_t i = 0; i < size; ++i)
+      {
+         if(!float_eq(lhs[i], rhs[i], max_ulps_diff))
+         {
+            return false;
+         }
+      }
+      return true;
+   }
+}
+
+/********************************/
+// report of mismatching elements in contiguous ranges
+/********************************/
+/**
+ * Summary of the elements of two ranges that are not within a number of ulps.
+ * Holds at most 'limit' first and 'limit' worst mismatches, so memory and output
+ * are bounded regardless of the size of the ranges.
+ **/
+template<class I>
+struct ulp_report
+{
+   struct mismatch
+   {
+      std::size_t _index;
+      I           _ulps;
+   };
+
+   std::size_t           _lhs_size   = 0;
+   std::size_t           _rhs_size   = 0;
+   std::size_t           _compared   = 0;   // elements covered by '_mismatches' and '_max_ulps'
+   std::size_t           _mismatches = 0;
+   I                     _max_ulps   = 0;
+   I                     _tolerance  = 0;
+   std::vector<mismatch> _first;
+   std::vector<mismatch> _worst;   // sorted worst first
+};
+
+/**
+ * Create report of the elements in two ranges further apart than 'max_ulps'.
+ * If 'comp_zero' the distance of each element is taken as in float_numeq_zero.
+ * The inputs are only read, never copied.
+ **/
+template
+   <  class L
+   ,  class R
+   ,  typename std::enable_if_t<is_float_range_v<L> && is_float_range_v<R> >* = nullptr
+   >
+ulp_report<integer_type<contiguous_range_value_t<L> > > make_ulp_report
+   (  const L& a_lhs
+   ,  const R& a_rhs
+   ,  const integer_type<contiguous_range_value_t<L> > max_ulps
+   ,  bool comp_zero   = false
+   ,  std::size_t limit = 10
+   )
+{
+   using T = contiguous_range_value_t<L>;
+   using report_type = ulp_report<integer_type<T> >;
+   using mismatch    = typename report_type::mismatch;
+
+   report_type report;
+   report._lhs_size  = static_cast<std::size_t>(std::size(a_lhs));
+   report._rhs_size  = static_cast<std::size_t>(std::size(a_rhs));
+   report._tolerance = max_ulps;
+
+   const T* lhs = std::data(a_lhs);
+   const T* rhs = std::data(a_rhs);
+   const std::size_t size = std::min(report._lhs_size, report._rhs_size);
+   report._compared = size;
+
+   // Min-heap on ulps, so the least bad of the kept worst mismatches is on top
+   auto better = [](const mismatch& a, const mismatch& b) { return a._ulps > b._ulps || (a._ulps == b._ulps && a._index < b._index); };
+   report._first.reserve(limit);
+   report._worst.reserve(limit);
+
+   for(std::size_t i = 0; i < size; ++i)
+   {
+      auto ulps = comp_zero ? float_ulps(lhs[i], lhs[i] + rhs[i]) : float_ulps(lhs[i], rhs[i]);
+      report._max_ulps = std::max(report._max_ulps, ulps);
+      if(ulps <= max_ulps)
+      {
+         continue;
+      }
+
+      ++report._mismatches;
+      if(report._first.size() < limit)
+      {
+         report._first.emplace_back(mismatch{i, ulps});
+      }
+      if(report._worst.size() < limit)
+      {
+         report._worst.emplace_back(mismatch{i, ulps});
+         std::push_heap(report._worst.begin(), report._worst.end(), better);
+      }
+      else if(limit && ulps > report._worst.front()._ulps)
+      {
+         std::pop_heap(report._worst.begin(), report._worst.end(), better);
+         report._worst.back() = mismatch{i, ulps};
+         std::push_heap(report._worst.begin(), report._worst.end(), better);
+      }
+   }
+
+   std::sort(report._worst.begin(), report._worst.end(), better);
+   return report;
+}
+
+/**
+ * Create report from the result of an (e.g. multi-threaded) ulp_compare of the two ranges, without comparing them again.
+ * Only the first mismatch is known, and the counts cover the '_compared' elements of the result.
+ **/
+template
+   <  class L
+   ,  class R
+   ,  class U
+   ,  typename std::enable_if_t<is_float_range_v<L> && is_float_range_v<R> >* = nullptr
+   >
+ulp_report<integer_type<contiguous_range_value_t<L> > > make_ulp_report
+   (  const L& a_lhs
+   ,  const R& a_rhs
+   ,  const integer_type<contiguous_range_value_t<L> > max_ulps
+   ,  const ulp_compare_result<U>& result
    )
 {
-   bool equal = (a_lhs.size() == a_rhs.size());
-   if (equal)
+   using I = integer_type<contiguous_range_value_t<L> >;
+   using report_type = ulp_report<I>;
+
+   report_type report;
+   report._lhs_size   = static_cast<std::size_t>(std::size(a_lhs));
+   report._rhs_size   = static_cast<std::size_t>(std::size(a_rhs));
+   report._compared   = result._compared;
+   report._mismatches = result._mismatches;
+   report._max_ulps   = static_cast<I>(result._max_ulps);
+   report._tolerance  = max_ulps;
+
+   auto i = result._first_mismatch;
+   if(i < report._lhs_size && i < report._rhs_size)
    {
-      for(decltype(a_lhs.size()) i = 0; i < a_lhs.size(); ++i)
+      report._first.emplace_back(typename report_type::mismatch{i, float_ulps(std::data(a_lhs)[i], std::data(a_rhs)[i])});
+   }
+   return report;
+}
+
+template<class I>
+std::ostream& operator<<(std::ostream& os, const ulp_report<I>& report)
+{
+   auto print = [&os](const char* label, const auto& mismatches)
+   {
+      os << "; " << label << ":";
+      for(const auto& m : mismatches)
+      {
+         os << " [" << m._index << "]=" << m._ulps;
+      }
+   };
+
+   if(report._lhs_size != report._rhs_size)
+   {
+      os << "sizes differ (" << report._lhs_size << " vs " << report._rhs_size << ")";
+      if(report._compared == 0)
+      {
+         return os;
+      }
+      os << ", ";
+   }
+   auto size = std::min(report._lhs_size, report._rhs_size);
+   os << report._mismatches << " of " << (report._compared < size ? std::to_string(report._compared) + " compared (of " + std::to_string(size) + ")" : std::to_string(size))
+      << " elements differ by more than " << report._tolerance << " ulps, max " << report._max_ulps << " ulps";
+   if(report._mismatches)
+   {
+      print("first", report._first);
+      if(!report._worst.empty())
+      {
+         print("worst", report._worst);
+      }
+      if(report._mismatches > report._first.size())
       {
-         equal = equal && float_eq(a_lhs[i], a_rhs[i], max_ulps_diff);
+         os << "; ...";
       }
    }
-   return equal;
+   return os;
 }
 
 /********************************/
@@ -0,0 +1,201 @@
+#pragma once
+#ifndef CUTEE_FLOAT_EQ_PAR_HPP_INCLUDED
+#define CUTEE_FLOAT_EQ_PAR_HPP_INCLUDED
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "float_eq.hpp"
+#include "float_eq_simd.hpp"
+
+namespace cutee
+{
+
+namespace numeric
+{
+
+namespace detail
+{
+
+/**
+ * Number of workers of the running suite (0 if none). Set by the suite for the duration of a run,
+ * as parallel compares share the hardware threads with the workers.
+ **/
+inline unsigned& suite_workers()
+{
+   static unsigned workers = 0;
+   return workers;
+}
+
+/**
+ * Default number of threads for a parallel compare: the hardware threads left to each worker of the running suite.
+ **/
+inline unsigned default_compare_threads()
+{
+   auto threads = std::max(std::thread::hardware_concurrency(), 1u);
+   auto workers = std::max(suite_workers(), 1u);
+   return std::max(threads / workers, 1u);
+}
+
+} /* namespace detail */
+
+/**
+ * Multi-threaded version of ulp_compare for huge ranges.
+ *
+ * The range is cut into chunks of 'chunk' elements, handed out to 'nthreads' threads
+ * (0 for the hardware threads divided by the workers of the running suite) in increasing order. Once a mismatch is found,
+ * chunks starting after it are skipped. Chunks before it are always compared, so the
+ * index of the first mismatch is the same as for the serial comparison.
+ * The mismatch count and max ulps are merged from the compared chunks; if the comparison
+ * was cut short '_compared' is less than 'n' and they only cover the compared elements.
+ **/
+template
+   <  class T
+   ,  std::enable_if_t<has_ulp_kernel_v<T>, void*> = nullptr
+   >
+ulp_compare_result<detail::ulp_uint_t<T> > ulp_compare_par
+   (  const T*    lhs
+   ,  const T*    rhs
+   ,  std::size_t n
+   ,  detail::ulp_uint_t<T> max_ulps
+   ,  unsigned    nthreads = 0
+   ,  std::size_t chunk    = std::size_t{1} << 18
+   )
+{
+   using result_type = ulp_compare_result<detail::ulp_uint_t<T> >;
+
+   if(nthreads == 0)
+   {
+      nthreads = detail::default_compare_threads();
+   }
+   chunk = std::max(chunk, std::size_t{1});
+   const std::size_t nchunks = (n + chunk - 1) / chunk;
+   nthreads = static_cast<unsigned>(std::min<std::size_t>(nthreads, nchunks));
+   if(nthreads <= 1)
+   {
+      return ulp_compare(lhs, rhs, n, max_ulps);
+   }
+
+   std::atomic<std::size_t> next_chunk{0};
+   std::atomic<std::size_t> first_mismatch{result_type::npos};
+   std::vector<result_type> partial(nthreads);
+
+   auto work = [&](result_type& part)
+   {
+      std::size_t c;
+      while((c = next_chunk.fetch_add(1, std::memory_order_relaxed)) < nchunks)
+      {
+         const std::size_t begin = c * chunk;
+         if(begin > first_mismatch.load(std::memory_order_relaxed))
+         {
+            // Chunks are handed out in order, so all remaining chunks are after the mismatch
+            break;
+         }
+
+         const std::size_t size = std::min(chunk, n - begin);
+         auto r = ulp_compare(lhs + begin, rhs + begin, size, max_ulps);
+         part._mismatches += r._mismatches;
+         part._compared   += r._compared;
+         part._max_ulps    = std::max(part._max_ulps, r._max_ulps);
+
+         if(r._first_mismatch != result_type::npos)
+         {
+            auto index    = begin + r._first_mismatch;
+            auto previous = first_mismatch.load(std::memory_order_relaxed);
+            while(index < previous && !first_mismatch.compare_exchange_weak(previous, index, std::memory_order_relaxed))
+            {
+            }
+         }
+      }
+   };
+
+   {
+      std::vector<std::thread> threads;
+      threads.reserve(nthreads - 1);
+      for(unsigned i = 1; i < nthreads; ++i)
+      {
+         threads.emplace_back(work, std::ref(partial[i]));
+      }
+      work(partial[0]);
+      for(auto& t : threads)
+      {
+         t.join();
+      }
+   }
+
+   result_type result;
+   for(const auto& part : partial)
+   {
+      result._mismatches += part._mismatches;
+      result._compared   += part._compared;
+      result._max_ulps    = std::max(result._max_ulps, part._max_ulps);
+   }
+   result._first_mismatch = first_mismatch.load();
+   result._equal          = (result._mismatches == 0);
+   return result;
+}
+
+/********************************/
+// ulp compare (multi-threaded, for contiguous ranges)
+/********************************/
+/**
+ * Compare two contiguous ranges with ulp_compare_par. Ranges of different size are not equal,
+ * and are not compared at all ('_compared' is 0).
+ **/
+template
+   <  class L
+   ,  class R
+   ,  typename std::enable_if_t
+      <  is_float_range_v<L> 
+      && is_float_range_v<R> 
+      && std::is_same_v<contiguous_range_value_t<L>, contiguous_range_value_t<R> >
+      && has_ulp_kernel_v<contiguous_range_value_t<L> >
+      >* = nullptr
+   >
+ulp_compare_result<detail::ulp_uint_t<contiguous_range_value_t<L> > > ulp_compare_range_par
+   (  const L& a_lhs
+   ,  const R& a_rhs
+   ,  const integer_type<contiguous_range_value_t<L> > max_ulps_diff = 2
+   ,  unsigned nthreads = 0
+   )
+{
+   const std::size_t size = std::size(a_lhs);
+   if(size != static_cast<std::size_t>(std::size(a_rhs)))
+   {
+      ulp_compare_result<detail::ulp_uint_t<contiguous_range_value_t<L> > > result;
+      result._equal = false;
+      return result;
+   }
+   return ulp_compare_par(std::data(a_lhs), std::data(a_rhs), size, max_ulps_diff, nthreads);
+}
+
+/********************************/
+// float equal (multi-threaded, for contiguous ranges)
+/********************************/
+template
+   <  class L
+   ,  class R
+   ,  typename std::enable_if_t
+      <  is_float_range_v<L> 
+      && is_float_range_v<R> 
+      && std::is_same_v<contiguous_range_value_t<L>, contiguous_range_value_t<R> >
+      && has_ulp_kernel_v<contiguous_range_value_t<L> >
+      >* = nullptr
+   >
+bool float_eq_par
+   (  const L& a_lhs
+   ,  const R& a_rhs
+   ,  const integer_type<contiguous_range_value_t<L> > max_ulps_diff = 2
+   ,  unsigned nthreads = 0
+   )
+{
+   return ulp_compare_range_par(a_lhs, a_rhs, max_ulps_diff, nthreads)._equal;
+}
+
+} /* namespace numeric */
+
+} /* namespace cutee */
+
+#endif /* CUTEE_FLOAT_EQ_PAR_HPP_INCLUDED */
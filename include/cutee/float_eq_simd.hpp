@@ -0,0 +1,397 @@
+#pragma once
+#ifndef CUTEE_FLOAT_EQ_SIMD_HPP_INCLUDED
+#define CUTEE_FLOAT_EQ_SIMD_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if !defined(CUTEE_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CUTEE_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif /* x86 && (gcc || clang) */
+
+namespace cutee
+{
+
+namespace numeric
+{
+
+/**
+ * Result of comparing two ranges of floating point numbers element by element.
+ **/
+template<class I>
+struct ulp_compare_result
+{
+   static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+   bool        _equal          = true;  // all elements within max ulps
+   std::size_t _first_mismatch = npos;  // index of first element not within max ulps
+   std::size_t _mismatches     = 0;     // number of elements not within max ulps
+   I           _max_ulps       = 0;     // largest distance in ulps
+   std::size_t _compared       = 0;     // number of elements compared (less than size if comparison was cut short)
+};
+
+template<class T>
+struct is_ulp_compare_result
+   :  std::false_type
+{
+};
+
+template<class I>
+struct is_ulp_compare_result<ulp_compare_result<I> >
+   :  std::true_type
+{
+};
+
+template<class T>
+constexpr bool is_ulp_compare_result_v = is_ulp_compare_result<T>::value;
+
+/**
+ * Instruction set used by the comparison kernels.
+ **/
+enum class simd_level : int { scalar, avx2, avx512 };
+
+/**
+ * Detect best instruction set supported by the running CPU (checked once).
+ **/
+inline simd_level detect_simd_level()
+{
+#ifdef CUTEE_HAVE_X86_SIMD
+   static const simd_level level = []()
+   {
+      __builtin_cpu_init();
+      if(__builtin_cpu_supports("avx512f"))
+      {
+         return simd_level::avx512;
+      }
+      if(__builtin_cpu_supports("avx2"))
+      {
+         return simd_level::avx2;
+      }
+      return simd_level::scalar;
+   }();
+   return level;
+#else
+   return simd_level::scalar;
+#endif /* CUTEE_HAVE_X86_SIMD */
+}
+
+namespace detail
+{
+
+/**
+ * Unsigned integer with same size as float type.
+ **/
+template<class T>
+using ulp_uint_t = std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+
+/**
+ * Map sign-and-magnitude bits to biased representation, where the integer order is the float order.
+ * Same as floating_point<T>::sign_and_magnitude_to_biased.
+ **/
+template<class U>
+inline U to_biased(U bits)
+{
+   constexpr U sign = U(1) << (8 * sizeof(U) - 1);
+   return (bits & sign) ? U(~bits + 1) : U(bits | sign);
+}
+
+/**
+ * Scalar kernel, used as fallback and for the tail of the vector kernels.
+ **/
+template<class T, class R>
+void ulp_compare_scalar(const T* lhs, const T* rhs, std::size_t begin, std::size_t end, ulp_uint_t<T> max_ulps, R& result)
+{
+   using uint_t = ulp_uint_t<T>;
+   for(std::size_t i = begin; i < end; ++i)
+   {
+      uint_t a, b;
+      std::memcpy(&a, lhs + i, sizeof(T));
+      std::memcpy(&b, rhs + i, sizeof(T));
+      a = to_biased(a);
+      b = to_biased(b);
+      uint_t d = a >= b ? a - b : b - a;
+      if(d > max_ulps)
+      {
+         if(result._first_mismatch == R::npos)
+         {
+            result._first_mismatch = i;
+         }
+         ++result._mismatches;
+      }
+      if(d > result._max_ulps)
+      {
+         result._max_ulps = d;
+      }
+   }
+}
+
+#ifdef CUTEE_HAVE_X86_SIMD
+/**
+ * Fold a block of per-element results into the total result.
+ * 'mask' has bit k set if element 'offset + k' is a mismatch.
+ **/
+template<class R>
+inline void accumulate_mismatch(R& result, std::uint64_t mask, std::size_t offset)
+{
+   if(mask)
+   {
+      if(result._first_mismatch == R::npos)
+      {
+         result._first_mismatch = offset + static_cast<std::size_t>(__builtin_ctzll(mask));
+      }
+      result._mismatches += static_cast<std::size_t>(__builtin_popcountll(mask));
+   }
+}
+
+/**
+ * Vector versions of to_biased.
+ **/
+__attribute__((target("avx2")))
+inline __m256i to_biased_epi64(__m256i x, __m256i zero, __m256i sign)
+{
+   __m256i neg = _mm256_cmpgt_epi64(zero, x);
+   return _mm256_blendv_epi8(_mm256_or_si256(x, sign), _mm256_sub_epi64(zero, x), neg);
+}
+
+__attribute__((target("avx2")))
+inline __m256i to_biased_epi32(__m256i x, __m256i zero, __m256i sign)
+{
+   __m256i neg = _mm256_srai_epi32(x, 31);
+   return _mm256_blendv_epi8(_mm256_or_si256(x, sign), _mm256_sub_epi32(zero, x), neg);
+}
+
+__attribute__((target("avx512f")))
+inline __m512i to_biased_epi64(__m512i x, __m512i zero, __m512i sign)
+{
+   __mmask8 neg = _mm512_cmplt_epi64_mask(x, zero);
+   return _mm512_mask_sub_epi64(_mm512_or_si512(x, sign), neg, zero, x);
+}
+
+__attribute__((target("avx512f")))
+inline __m512i to_biased_epi32(__m512i x, __m512i zero, __m512i sign)
+{
+   __mmask16 neg = _mm512_cmplt_epi32_mask(x, zero);
+   return _mm512_mask_sub_epi32(_mm512_or_si512(x, sign), neg, zero, x);
+}
+
+/**
+ * AVX2 kernels. AVX2 has no unsigned 64-bit compare, so the sign bit is flipped
+ * before using the signed compare.
+ **/
+template<class R>
+__attribute__((target("avx2")))
+void ulp_compare_avx2(const double* lhs, const double* rhs, std::size_t n, std::uint64_t max_ulps, R& result)
+{
+   const __m256i zero = _mm256_setzero_si256();
+   const __m256i sign = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ull));
+   const __m256i maxs = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(max_ulps)), sign);
+   __m256i       acc  = _mm256_setzero_si256();
+
+   std::size_t i = 0;
+   for(; i + 4 <= n; i += 4)
+   {
+      __m256i a  = to_biased_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i)), zero, sign);
+      __m256i b  = to_biased_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i)), zero, sign);
+      __m256i gt = _mm256_cmpgt_epi64(_mm256_xor_si256(a, sign), _mm256_xor_si256(b, sign));
+      __m256i d  = _mm256_blendv_epi8(_mm256_sub_epi64(b, a), _mm256_sub_epi64(a, b), gt);
+      __m256i ds = _mm256_xor_si256(d, sign);
+      __m256i mm = _mm256_cmpgt_epi64(ds, maxs);
+      acc = _mm256_blendv_epi8(acc, d, _mm256_cmpgt_epi64(ds, _mm256_xor_si256(acc, sign)));
+      accumulate_mismatch(result, static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(mm))), i);
+   }
+
+   alignas(32) std::uint64_t lanes[4];
+   _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+   for(auto lane : lanes)
+   {
+      result._max_ulps = lane > result._max_ulps ? lane : result._max_ulps;
+   }
+
+   ulp_compare_scalar(lhs, rhs, i, n, max_ulps, result);
+}
+
+template<class R>
+__attribute__((target("avx2")))
+void ulp_compare_avx2(const float* lhs, const float* rhs, std::size_t n, std::uint32_t max_ulps, R& result)
+{
+   const __m256i zero = _mm256_setzero_si256();
+   const __m256i sign = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+   const __m256i maxs = _mm256_set1_epi32(static_cast<int>(max_ulps));
+   __m256i       acc  = _mm256_setzero_si256();
+
+   std::size_t i = 0;
+   for(; i + 8 <= n; i += 8)
+   {
+      __m256i a  = to_biased_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i)), zero, sign);
+      __m256i b  = to_biased_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i)), zero, sign);
+      __m256i d  = _mm256_sub_epi32(_mm256_max_epu32(a, b), _mm256_min_epu32(a, b));
+      __m256i ok = _mm256_cmpeq_epi32(_mm256_max_epu32(d, maxs), maxs);
+      acc = _mm256_max_epu32(acc, d);
+      accumulate_mismatch(result, static_cast<std::uint64_t>(~_mm256_movemask_ps(_mm256_castsi256_ps(ok)) & 0xff), i);
+   }
+
+   alignas(32) std::uint32_t lanes[8];
+   _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+   for(auto lane : lanes)
+   {
+      result._max_ulps = lane > result._max_ulps ? lane : result._max_ulps;
+   }
+
+   ulp_compare_scalar(lhs, rhs, i, n, max_ulps, result);
+}
+
+/**
+ * AVX-512 kernels. Written with masked operations instead of _mm512_max_epu64 and friends,
+ * which give spurious uninitialized warnings with some versions of GCC.
+ **/
+template<class R>
+__attribute__((target("avx512f")))
+void ulp_compare_avx512(const double* lhs, const double* rhs, std::size_t n, std::uint64_t max_ulps, R& result)
+{
+   const __m512i zero = _mm512_setzero_si512();
+   const __m512i sign = _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ull));
+   const __m512i maxs = _mm512_set1_epi64(static_cast<long long>(max_ulps));
+   __m512i       acc  = _mm512_setzero_si512();
+
+   std::size_t i = 0;
+   for(; i + 8 <= n; i += 8)
+   {
+      __m512i a = to_biased_epi64(_mm512_loadu_si512(lhs + i), zero, sign);
+      __m512i b = to_biased_epi64(_mm512_loadu_si512(rhs + i), zero, sign);
+      __m512i d = _mm512_mask_sub_epi64(_mm512_sub_epi64(b, a), _mm512_cmpgt_epu64_mask(a, b), a, b);
+      acc = _mm512_mask_mov_epi64(acc, _mm512_cmpgt_epu64_mask(d, acc), d);
+      accumulate_mismatch(result, static_cast<std::uint64_t>(_mm512_cmpgt_epu64_mask(d, maxs)), i);
+   }
+
+   alignas(64) std::uint64_t lanes[8];
+   _mm512_store_si512(lanes, acc);
+   for(auto lane : lanes)
+   {
+      result._max_ulps = lane > result._max_ulps ? lane : result._max_ulps;
+   }
+
+   ulp_compare_scalar(lhs, rhs, i, n, max_ulps, result);
+}
+
+template<class R>
+__attribute__((target("avx512f")))
+void ulp_compare_avx512(const float* lhs, const float* rhs, std::size_t n, std::uint32_t max_ulps, R& result)
+{
+   const __m512i zero = _mm512_setzero_si512();
+   const __m512i sign = _mm512_set1_epi32(static_cast<int>(0x80000000u));
+   const __m512i maxs = _mm512_set1_epi32(static_cast<int>(max_ulps));
+   __m512i       acc  = _mm512_setzero_si512();
+
+   std::size_t i = 0;
+   for(; i + 16 <= n; i += 16)
+   {
+      __m512i a = to_biased_epi32(_mm512_loadu_si512(lhs + i), zero, sign);
+      __m512i b = to_biased_epi32(_mm512_loadu_si512(rhs + i), zero, sign);
+      __m512i d = _mm512_mask_sub_epi32(_mm512_sub_epi32(b, a), _mm512_cmpgt_epu32_mask(a, b), a, b);
+      acc = _mm512_mask_mov_epi32(acc, _mm512_cmpgt_epu32_mask(d, acc), d);
+      accumulate_mismatch(result, static_cast<std::uint64_t>(_mm512_cmpgt_epu32_mask(d, maxs)), i);
+   }
+
+   alignas(64) std::uint32_t lanes[16];
+   _mm512_store_si512(lanes, acc);
+   for(auto lane : lanes)
+   {
+      result._max_ulps = lane > result._max_ulps ? lane : result._max_ulps;
+   }
+
+   ulp_compare_scalar(lhs, rhs, i, n, max_ulps, result);
+}
+#endif /* CUTEE_HAVE_X86_SIMD */
+
+} /* namespace detail */
+
+/**
+ * Does ulp_compare have kernels for T.
+ **/
+template<class T>
+constexpr bool has_ulp_kernel_v = std::is_floating_point_v<T> && (sizeof(T) == 8 || sizeof(T) == 4) && std::numeric_limits<T>::is_iec559;
+
+/**
+ * Compare two contiguous ranges of 'n' floats element by element.
+ * Returns whether all elements are within 'max_ulps' of each other, the index of the first
+ * element that is not, the number of such elements, and the largest distance in ulps.
+ * Uses AVX-512 or AVX2 when the CPU supports it, unless a lower 'level' is requested.
+ **/
+template
+   <  class T
+   ,  std::enable_if_t<has_ulp_kernel_v<T>, void*> = nullptr
+   >
+ulp_compare_result<detail::ulp_uint_t<T> > ulp_compare
+   (  const T*    lhs
+   ,  const T*    rhs
+   ,  std::size_t n
+   ,  detail::ulp_uint_t<T> max_ulps
+   ,  simd_level  level = detect_simd_level()
+   )
+{
+   ulp_compare_result<detail::ulp_uint_t<T> > result;
+
+   if(level > detect_simd_level())
+   {
+      level = detect_simd_level();
+   }
+
+   switch(level)
+   {
+#ifdef CUTEE_HAVE_X86_SIMD
+      case simd_level::avx512:
+         detail::ulp_compare_avx512(lhs, rhs, n, max_ulps, result);
+         break;
+      case simd_level::avx2:
+         detail::ulp_compare_avx2(lhs, rhs, n, max_ulps, result);
+         break;
+#endif /* CUTEE_HAVE_X86_SIMD */
+      default:
+         detail::ulp_compare_scalar(lhs, rhs, 0, n, max_ulps, result);
+         break;
+   }
+
+   result._equal    = (result._mismatches == 0);
+   result._compared = n;
+   return result;
+}
+
+/**
+ * Check if two contiguous ranges of 'n' floats are within 'max_ulps' of each other element by element.
+ * Same as ulp_compare(...)._equal, but compares in blocks of 'block' elements and stops at
+ * the first block with a mismatch, instead of counting all mismatches.
+ **/
+template
+   <  class T
+   ,  std::enable_if_t<has_ulp_kernel_v<T>, void*> = nullptr
+   >
+bool ulp_equal
+   (  const T*    lhs
+   ,  const T*    rhs
+   ,  std::size_t n
+   ,  detail::ulp_uint_t<T> max_ulps
+   ,  simd_level  level = detect_simd_level()
+   ,  std::size_t block = 4096
+   )
+{
+   block = block ? block : 1;
+   for(std::size_t begin = 0; begin < n; begin += block)
+   {
+      auto size = n - begin < block ? n - begin : block;
+      if(!ulp_compare(lhs + begin, rhs + begin, size, max_ulps, level)._equal)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+} /* namespace numeric */
+
+} /* namespace cutee */
+
+#endif /* CUTEE_FLOAT_EQ_SIMD_HPP_INCLUDED */
@@ -3,9 +3,18 @@
 #define CUTEE_FORMATER_HPP_INCLUDED
 
 #include <map>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <locale>
+#include <cctype>
+#include <algorithm>
 #include <functional>
-#include <regex>
+
+#include "typedef.hpp"
 
 namespace cutee
 {
@@ -39,7 +48,59 @@ static inline std::string remove_whitespace_copy(std::string s)
 } /* namespace detail */
 
 /**
- * Formater symbol replacer
+ * Symbols known by the formater, written as '[/name]' in messages.
+ **/
+enum class symbol : int 
+   {  bold_on
+   ,  bold_off
+   ,  default_color
+   ,  warning_color
+   ,  file_color
+   ,  type_color
+   ,  name_color
+   ,  value_color
+   ,  none
+   };
+
+constexpr std::size_t symbol_count = static_cast<std::size_t>(symbol::none);
+
+namespace detail
+{
+
+/**
+ * Find symbol from its name.
+ **/
+inline symbol find_symbol(std::string_view name)
+{
+   static constexpr std::string_view names[symbol_count] = 
+      {  "bold_on"
+      ,  "bold_off"
+      ,  "default_color"
+      ,  "warning_color"
+      ,  "file_color"
+      ,  "type_color"
+      ,  "name_color"
+      ,  "value_color"
+      };
+
+   for(std::size_t i = 0; i < symbol_count; ++i)
+   {
+      if(names[i] == name)
+      {
+         return static_cast<symbol>(i);
+      }
+   }
+   return symbol::none;
+}
+
+} /* namespace detail */
+
+/**
+ * Formater symbol replacer.
+ *
+ * Replaces every '[/name]' in a message in a single pass. Known names are resolved to a 'symbol'
+ * and replaced by 'symbol_string', other names are looked up in '_map', and tags with unknown
+ * names are removed. Tags do not span lines.
  **/
 struct symbol_replacer
 {
@@ -49,8 +110,9 @@ struct symbol_replacer
 
    map_t       _map;
    bool        _remove_whitespace{true};
-   std::regex  _regex            {"\\[/(.*?)\\]"}; // match inside square brackets '[...]'
    
+   symbol_replacer() = default;
+
    symbol_replacer(map_t&& map)
       :  _map(std::move(map))
    {
@@ -58,33 +120,58 @@ struct symbol_replacer
 
    virtual ~symbol_replacer() = default;
 
-   std::string& replace_in_string(std::string& str) const
+   /**
+    * Get string for known symbol, or nullptr if not handled.
+    **/
+   virtual const char* symbol_string(symbol) const
    {
-      try 
+      return nullptr;
+   }
+
+   /**
+    * Append 'in' with tags replaced to 'out'.
+    **/
+   void replace_into(std::string_view in, std::string& out) const
+   {
+      std::size_t pos = 0;
+      while(pos < in.size())
       {
-         std::smatch match;
-         typename map_t::const_iterator iter;
-         
-         while (std::regex_search(str, match, _regex))
+         auto open = in.find("[/", pos);
+         if(open == std::string_view::npos)
          {
-            auto key = _remove_whitespace ? detail::remove_whitespace_copy(match.str(1)) : match.str(1);
-            if(!key.empty() && (iter = _map.find(key)) != _map.end())
-            {
-               str.replace(match.prefix().second, match.suffix().first, (iter->second)());
-            }
-            else
-            {
-               str.erase(match.prefix().second, match.suffix().first);
-            }
+            break;
          }
-      } 
-      catch (std::regex_error& e) 
-      {
-         // Syntax error in the regular expression
-         std::cerr << " symbol_replacer : regex error !" << std::endl;
-         throw;
-      } 
 
+         auto close = open + 2;
+         while(close < in.size() && in[close] != ']' && in[close] != '\n')
+         {
+            ++close;
+         }
+         if(close == in.size())
+         {
+            break;
+         }
+         if(in[close] == '\n')
+         {
+            // Not a tag, keep text up to the newline as is
+            out.append(in, pos, close - pos);
+            pos = close;
+            continue;
+         }
+
+         out.append(in, pos, open - pos);
+         this->append_symbol(in.substr(open + 2, close - open - 2), out);
+         pos = close + 1;
+      }
+      out.append(in, std::min(pos, in.size()), std::string_view::npos);
+   }
+
+   std::string& replace_in_string(std::string& str) const
+   {
+      std::string out;
+      out.reserve(str.size());
+      this->replace_into(str, out);
+      str.swap(out);
       return str;
    }
 
@@ -97,6 +184,40 @@ struct symbol_replacer
    {
       return replace_in_string(str);
    }
+
+   private:
+      void append_symbol(std::string_view key, std::string& out) const
+      {
+         std::string stripped;
+         if(_remove_whitespace && std::any_of(key.begin(), key.end(), [](char c) { return std::isspace(static_cast<unsigned char>(c)); }))
+         {
+            stripped = detail::remove_whitespace_copy(std::string{key});
+            key      = stripped;
+         }
+         if(key.empty())
+         {
+            return;
+         }
+
+         auto sym = detail::find_symbol(key);
+         if(sym != symbol::none)
+         {
+            if(const char* str = this->symbol_string(sym))
+            {
+               out.append(str);
+               return;
+            }
+         }
+         
+         if(!_map.empty())
+         {
+            auto iter = _map.find(key_t{key});
+            if(iter != _map.end())
+            {
+               out.append((iter->second)());
+            }
+         }
+      }
 };
 
 
@@ -106,24 +227,37 @@ struct symbol_replacer
 struct formater
    :  public symbol_replacer
 {
-   formater()
-      :  symbol_replacer
-         {  symbol_replacer::map_t
-            {  {"bold_on" ,      [this](){ return this->bold_on() ; } }
-            ,  {"bold_off",      [this](){ return this->bold_off(); } }
-            ,  {"default_color", [this](){ return this->default_color(); } }
-            ,  {"warning_color", [this](){ return this->warning_color(); } }
-            ,  {"file_color",    [this](){ return this->file_color(); } }
-            ,  {"type_color",    [this](){ return this->type_color(); } }
-            ,  {"name_color",    [this](){ return this->name_color(); } }
-            ,  {"value_color",   [this](){ return this->value_color(); } }
-            }
-         }
-   {
-   }
+   formater() = default;
 
    virtual ~formater() = default;
 
+   /**
+    * Symbol strings are looked up once (on first use, as the derived formater must be constructed),
+    * and kept in a table indexed by symbol.
+    **/
+   const char* symbol_string(symbol sym) const override
+   {
+      if(CUTEE_UNLIKELY(!_resolved.load(std::memory_order_acquire)))
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         if(!_resolved.load(std::memory_order_relaxed))
+         {
+            _table = 
+               {  this->bold_on()
+               ,  this->bold_off()
+               ,  this->default_color()
+               ,  this->warning_color()
+               ,  this->file_color()
+               ,  this->type_color()
+               ,  this->name_color()
+               ,  this->value_color()
+               };
+            _resolved.store(true, std::memory_order_release);
+         }
+      }
+      return _table[static_cast<std::size_t>(sym)];
+   }
+
    virtual const char* bold_on() const = 0;
    
    virtual const char* bold_off() const = 0;
@@ -139,6 +273,11 @@ struct formater
    virtual const char* name_color() const = 0;
    
    virtual const char* value_color() const = 0;
+
+   private:
+      mutable std::mutex                            _mutex;
+      mutable std::atomic<bool>                     _resolved{false};
+      mutable std::array<const char*, symbol_count> _table{};
 };
 
 template<class T>
@@ -0,0 +1,135 @@
+#pragma once
+#ifndef CUTEE_JSONL_WRITER_HPP_INCLUDED
+#define CUTEE_JSONL_WRITER_HPP_INCLUDED
+
+#include <iostream>
+#include <string>
+
+#include "writer.hpp"
+#include "event.hpp"
+#include "escape.hpp"
+
+namespace cutee
+{
+
+/**
+ * Writer streaming JSON Lines, one object per line:
+ *
+ *    {"type":"suite_start","suite":...,"tests":N}
+ *    {"type":"test","suite":...,"name":...,"status":"passed"|"failed","duration":s,"assertions":N,
+ *     "output":...,"captured":...,"allocations":N,"allocated_bytes":N,"frees":N,"failures":[{"message":...,"file":...,"line":N,"values":[{"label":...,"value":...,"type":...}]}]}
+ *    {"type":"suite_end","suite":...,"tests":N,"assertions":N,"failed":N,"duration":s}
+ **/
+struct jsonl_writer
+   :  public writer
+{
+   std::ostream&       _os;
+   mutable std::string _buffer;
+   mutable std::string _suite;
+
+   explicit jsonl_writer(std::ostream& os)
+      :  _os(os)
+   {
+   }
+
+   //! Rendered text output is not used.
+   void write(const std::string&) const
+   {
+   }
+
+   void flush() const
+   {
+      _os.flush();
+   }
+
+   void begin_suite(const suite_event& event) const
+   {
+      _suite = event._name;
+      _buffer = "{\"type\":\"suite_start\",\"suite\":";
+      detail::append_json_string(_buffer, event._name);
+      _buffer += ",\"tests\":" + std::to_string(event._num_tests) + "}\n";
+      this->output();
+   }
+
+   void test_finished(const test_event& event) const
+   {
+      _buffer = "{\"type\":\"test\",\"suite\":";
+      detail::append_json_string(_buffer, _suite);
+      _buffer += ",\"name\":";
+      detail::append_json_string(_buffer, event._name);
+      _buffer += event._failed ? ",\"status\":\"failed\"" : ",\"status\":\"passed\"";
+      _buffer += ",\"duration\":";
+      detail::append_number(_buffer, event._duration);
+      _buffer += ",\"assertions\":" + std::to_string(event._num_assertions);
+      if(!event._output.empty())
+      {
+         _buffer += ",\"output\":";
+         detail::append_json_string(_buffer, event._output);
+      }
+      if(!event._captured.empty())
+      {
+         _buffer += ",\"captured\":";
+         detail::append_json_string(_buffer, event._captured);
+      }
+      if(alloc::tracking())
+      {
+         _buffer += ",\"allocations\":"     + std::to_string(event._allocations._allocations);
+         _buffer += ",\"allocated_bytes\":" + std::to_string(event._allocations._bytes);
+         _buffer += ",\"frees\":"           + std::to_string(event._allocations._frees);
+      }
+      if(!event._failures.empty())
+      {
+         _buffer += ",\"failures\":[";
+         for(std::size_t i = 0; i < event._failures.size(); ++i)
+         {
+            const auto& f = event._failures[i];
+            _buffer += i ? ",{\"message\":" : "{\"message\":";
+            detail::append_json_string(_buffer, f._message);
+            if(!f._file.empty())
+            {
+               _buffer += ",\"file\":";
+               detail::append_json_string(_buffer, f._file);
+               _buffer += ",\"line\":" + std::to_string(f._line);
+            }
+            _buffer += ",\"values\":[";
+            for(std::size_t j = 0; j < f._values.size(); ++j)
+            {
+               _buffer += j ? ",{\"label\":" : "{\"label\":";
+               detail::append_json_string(_buffer, f._values[j]._label);
+               _buffer += ",\"value\":";
+               detail::append_json_string(_buffer, f._values[j]._value);
+               _buffer += ",\"type\":";
+               detail::append_json_string(_buffer, f._values[j]._type);
+               _buffer += "}";
+            }
+            _buffer += "]}";
+         }
+         _buffer += "]";
+      }
+      _buffer += "}\n";
+      this->output();
+   }
+
+   void end_suite(const suite_summary& summary) const
+   {
+      _buffer = "{\"type\":\"suite_end\",\"suite\":";
+      detail::append_json_string(_buffer, summary._name);
+      _buffer += ",\"tests\":"      + std::to_string(summary._num_tests);
+      _buffer += ",\"assertions\":" + std::to_string(summary._num_assertions);
+      _buffer += ",\"failed\":"     + std::to_string(summary._num_failed);
+      _buffer += ",\"duration\":";
+      detail::append_number(_buffer, summary._duration);
+      _buffer += "}\n";
+      this->output();
+   }
+
+   private:
+      void output() const
+      {
+         _os.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+      }
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_JSONL_WRITER_HPP_INCLUDED */
@@ -0,0 +1,152 @@
+#pragma once
+#ifndef CUTEE_JUNIT_WRITER_HPP_INCLUDED
+#define CUTEE_JUNIT_WRITER_HPP_INCLUDED
+
+#include <iostream>
+#include <string>
+
+#include "writer.hpp"
+#include "event.hpp"
+#include "escape.hpp"
+
+namespace cutee
+{
+
+/**
+ * Writer streaming JUnit XML. Each test case is written as soon as it has finished,
+ * so memory use does not depend on the size of the suite. The closing '</testsuites>'
+ * is written when the writer is destroyed, closing first a '<testsuite>' that was not ended
+ * (e.g. when a test exception stopped the run), so the document is always well formed.
+ **/
+struct junit_writer
+   :  public writer
+{
+   using formater_ptr_t = typename format::formater_ptr_t;
+
+   std::ostream&       _os;
+   formater_ptr_t      _raw      = format::create(format::raw);
+   mutable std::string _buffer;
+   mutable std::string _suite;
+   mutable bool        _open     = false;   // '<testsuites>' written
+   mutable bool        _in_suite = false;   // '<testsuite>' written but not closed
+
+   explicit junit_writer(std::ostream& os)
+      :  _os(os)
+   {
+   }
+
+   ~junit_writer()
+   {
+      if(_open)
+      {
+         if(_in_suite)
+         {
+            _os << "  </testsuite>\n";
+         }
+         _os << "</testsuites>\n";
+         _os.flush();
+      }
+   }
+
+   //! Rendered text output is not used.
+   void write(const std::string&) const
+   {
+   }
+
+   void flush() const
+   {
+      _os.flush();
+   }
+
+   void begin_suite(const suite_event& event) const
+   {
+      _buffer.clear();
+      if(!_open)
+      {
+         _buffer += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites>\n";
+         _open = true;
+      }
+      if(_in_suite)
+      {
+         _buffer += "  </testsuite>\n";
+      }
+      _in_suite = true;
+      _suite = event._name;
+      _buffer += "  <testsuite name=\"";
+      detail::append_xml_escaped(_buffer, event._name);
+      _buffer += "\" tests=\"" + std::to_string(event._num_tests) + "\">\n";
+      this->output();
+   }
+
+   void test_finished(const test_event& event) const
+   {
+      _buffer.clear();
+      _buffer += "    <testcase name=\"";
+      detail::append_xml_escaped(_buffer, event._name);
+      _buffer += "\" classname=\"";
+      detail::append_xml_escaped(_buffer, _suite);
+      _buffer += "\" time=\"";
+      detail::append_number(_buffer, event._duration);
+      _buffer += "\" assertions=\"" + std::to_string(event._num_assertions) + "\"";
+
+      if(event._failures.empty() && event._output.empty() && event._captured.empty())
+      {
+         _buffer += "/>\n";
+         this->output();
+         return;
+      }
+      _buffer += ">\n";
+
+      std::string text;
+      for(const auto& f : event._failures)
+      {
+         _buffer += "      <failure message=\"";
+         detail::append_xml_escaped(_buffer, f._message);
+         _buffer += "\" type=\"";
+         _buffer += f._file.empty() ? "error" : "assertion";
+         _buffer += "\">";
+         text.clear();
+         _raw->replace_into(f._text, text);
+         detail::append_xml_escaped(_buffer, text);
+         _buffer += "</failure>\n";
+      }
+      if(!event._output.empty())
+      {
+         _buffer += "      <system-out>";
+         text.clear();
+         _raw->replace_into(event._output, text);
+         detail::append_xml_escaped(_buffer, text);
+         _buffer += "</system-out>\n";
+      }
+      if(!event._captured.empty())
+      {
+         _buffer += "      <system-err>";
+         detail::append_xml_escaped(_buffer, event._captured);
+         _buffer += "</system-err>\n";
+      }
+      _buffer += "    </testcase>\n";
+      this->output();
+   }
+
+   void end_suite(const suite_summary&) const
+   {
+      if(!_in_suite)
+      {
+         return;
+      }
+      _buffer.clear();
+      _buffer += "  </testsuite>\n";
+      _in_suite = false;
+      this->output();
+   }
+
+   private:
+      void output() const
+      {
+         _os.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+      }
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_JUNIT_WRITER_HPP_INCLUDED */
@@ -4,32 +4,83 @@
 
 #include "suite.hpp"
 #include "float_eq.hpp"
+#include "float_eq_par.hpp"
+
+/**
+ * Assertion info. The message expression is wrapped in a lambda, so it is only evaluated if the assertion fails.
+ **/
+#define CUTEE_INFO(msg) \
+   cutee::make_info([&]() -> decltype(auto) { return (msg); }, __FILE__, __LINE__)
 
 /**
  * Assertion Macros
  **/
 #define UNIT_ASSERT(a, b) \
-   cutee::asserter::assertt(a, cutee::info{b, __FILE__, __LINE__});
+   cutee::asserter::assertt(a, CUTEE_INFO(b));
 
 #define UNIT_ASSERT_NOT(a, b) \
-   cutee::asserter::assert_not(a, cutee::info{b, __FILE__, __LINE__});
+   cutee::asserter::assert_not(a, CUTEE_INFO(b));
 
 #define UNIT_ASSERT_EQUAL(a, b, c) \
-   cutee::asserter::assert_equal(a, b, cutee::info{c, __FILE__, __LINE__});
+   cutee::asserter::assert_equal(a, b, CUTEE_INFO(c));
 
 #define UNIT_ASSERT_NOT_EQUAL(a, b, c) \
-   cutee::asserter::assert_not_equal(a, b, cutee::info{c, __FILE__, __LINE__});
+   cutee::asserter::assert_not_equal(a, b, CUTEE_INFO(c));
 
 #define UNIT_ASSERT_FEQUAL(a, b, c) \
-   cutee::asserter::assert_float_equal_prec(a, b, 2u, cutee::info{c, __FILE__, __LINE__});
+   cutee::asserter::assert_float_equal_prec(a, b, 2u, CUTEE_INFO(c));
 
 #define UNIT_ASSERT_FEQUAL_PREC(a, b, c, d) \
-   cutee::asserter::assert_float_equal_prec(a, b, c, cutee::info{d, __FILE__, __LINE__});
+   cutee::asserter::assert_float_equal_prec(a, b, c, CUTEE_INFO(d));
+
+#define UNIT_ASSERT_FEQUAL_PAR(a, b, c) \
+   cutee::asserter::assert_float_equal_par(a, b, 2u, CUTEE_INFO(c));
+
+#define UNIT_ASSERT_FEQUAL_PAR_PREC(a, b, c, d) \
+   cutee::asserter::assert_float_equal_par(a, b, c, CUTEE_INFO(d));
 
 #define UNIT_ASSERT_FZERO(a,b,c) \
-   cutee::asserter::assert_float_numeq_zero_prec(a, b, 2u, cutee::info{c, __FILE__, __LINE__});
+   cutee::asserter::assert_float_numeq_zero_prec(a, b, 2u, CUTEE_INFO(c));
 
 #define UNIT_ASSERT_FZERO_PREC(a,b,c,d) \
-   cutee::asserter::assert_float_numeq_zero_prec(a, b, c, cutee::info{d, __FILE__, __LINE__});
+   cutee::asserter::assert_float_numeq_zero_prec(a, b, c, CUTEE_INFO(d));
+
+/**
+ * Allocation assertions, need the cutee_alloc library to be linked in (see alloc.hpp).
+ * Counts allocations by the calling thread since the test started (including setup).
+ **/
+#define UNIT_ASSERT_MAX_ALLOCATIONS(n, b) \
+   cutee::asserter::assert_max_allocations(n, CUTEE_INFO(cutee::alloc::describe_limit(n) + ": " + std::string(b)));
+
+#define UNIT_EXPECT_MAX_ALLOCATIONS(n, b) \
+   cutee::asserter::assert_max_allocations<cutee::severity::soft>(n, CUTEE_INFO(cutee::alloc::describe_limit(n) + ": " + std::string(b)));
+
+/**
+ * Soft assertion macros. A failure is recorded and the test continues,
+ * all failures of the test are reported when it has finished.
+ **/
+#define UNIT_EXPECT(a, b) \
+   cutee::asserter::assertt<cutee::severity::soft>(a, CUTEE_INFO(b));
+
+#define UNIT_EXPECT_NOT(a, b) \
+   cutee::asserter::assert_not<cutee::severity::soft>(a, CUTEE_INFO(b));
+
+#define UNIT_EXPECT_EQUAL(a, b, c) \
+   cutee::asserter::assert_equal<cutee::severity::soft>(a, b, CUTEE_INFO(c));
+
+#define UNIT_EXPECT_NOT_EQUAL(a, b, c) \
+   cutee::asserter::assert_not_equal<cutee::severity::soft>(a, b, CUTEE_INFO(c));
+
+#define UNIT_EXPECT_FEQUAL(a, b, c) \
+   cutee::asserter::assert_float_equal_prec<cutee::severity::soft>(a, b, 2u, CUTEE_INFO(c));
+
+#define UNIT_EXPECT_FEQUAL_PREC(a, b, c, d) \
+   cutee::asserter::assert_float_equal_prec<cutee::severity::soft>(a, b, c, CUTEE_INFO(d));
+
+#define UNIT_EXPECT_FZERO(a,b,c) \
+   cutee::asserter::assert_float_numeq_zero_prec<cutee::severity::soft>(a, b, 2u, CUTEE_INFO(c));
+
+#define UNIT_EXPECT_FZERO_PREC(a,b,c,d) \
+   cutee::asserter::assert_float_numeq_zero_prec<cutee::severity::soft>(a, b, c, CUTEE_INFO(d));
 
 #endif /* CUTEE_MACROS_HPP_INCLUDED */
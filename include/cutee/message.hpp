@@ -8,12 +8,18 @@
 #include<type_traits>
 #include<complex>
 #include<iomanip>
+#include<algorithm>
+#include<string_view>
+#include<streambuf>
+#include<vector>
 
 #include "meta.hpp"
 #include "osutil.hpp"
 #include "formater.hpp"
 #include "assertion.hpp"
 #include "float_eq.hpp"
+#include "event.hpp"
+#include "diff.hpp"
 
 namespace cutee
 {
@@ -68,7 +74,8 @@ struct has_distance
    >
    :  public std::true_type
 {
-   constexpr static auto calculate_distance(const T& lhs, const U& rhs, const assertion_type& type)
+   template<class I>
+   constexpr static auto calculate_distance(const T& lhs, const U& rhs, const assertion_type& type, const I&)
    {
       if(type != assertion_type::comp_zero)
       {
@@ -100,7 +107,8 @@ struct has_distance
    >
    :  public std::true_type
 {
-   constexpr static auto calculate_distance(const T& lhs, const U& rhs, const assertion_type& type)
+   template<class I>
+   constexpr static auto calculate_distance(const T& lhs, const U& rhs, const assertion_type& type, const I&)
    {
       using base_type = decltype(numeric::float_ulps(lhs.real(), rhs.real()));
       if(type != assertion_type::comp_zero)
@@ -130,60 +138,221 @@ struct has_distance
    <  T
    ,  U
    ,  std::enable_if_t
-      <  std::is_same_v
-         <  std::decay_t<T>
-         ,  std::decay_t<U> 
-         > 
-      && is_vector_v<std::decay_t<T> > 
+      <  is_float_range_v<remove_cvref_t<T> >
+      && is_float_range_v<remove_cvref_t<U> >
+      && std::is_same_v
+         <  contiguous_range_value_t<remove_cvref_t<T> >
+         ,  contiguous_range_value_t<remove_cvref_t<U> >
+         >
       > 
    >
    :  public std::true_type
 {
-   constexpr static auto calculate_distance(const T& lhs, const U& rhs, const assertion_type& type)
+   /**
+    * Bounded report of the mismatching elements (first and worst few with their indices).
+    **/
+   template<class I>
+   static auto calculate_distance(const T& lhs, const U& rhs, const assertion_type& type, const I& ulps)
    {
-      using base_type = decltype(numeric::float_ulps(lhs[0], rhs[0]));
-      std::vector<base_type> ulps;
-      auto ulps_size = std::min(lhs.size(), rhs.size());
-      ulps.resize(ulps_size);
-      for(int i = 0; i < int(ulps_size); ++i)
+      return numeric::make_ulp_report(lhs, rhs, ulps, type == assertion_type::comp_zero);
+   }
+
+   static constexpr auto precision = std::numeric_limits<contiguous_range_value_t<remove_cvref_t<T> > >::max_digits10;
+};
+
+/**
+ * Limits on rendered values, so a failure on a huge container or string does not produce a huge message.
+ * Set from run_options by the suite before tests are run. 0 means no limit.
+ **/
+struct render_limits
+{
+   std::size_t _max_bytes      = 4096;  // bytes of a rendered value
+   std::size_t _max_elements   = 32;    // elements of a rendered range
+   std::size_t _window         = 8;     // elements shown on each side of the first difference of two ranges
+   std::size_t _string_window  = 64;    // bytes shown on each side of the first difference of two strings
+   std::size_t _diff_context   = 3;     // unchanged elements (or lines) shown around changes in a diff
+   diff::options _diff;                 // cutoffs for diffing, beyond which only the first difference is shown
+};
+
+inline render_limits& rendering()
+{
+   static render_limits limits;
+   return limits;
+}
+
+/**
+ * String buffer keeping at most 'max' bytes (0 for no limit). When it is full output fails,
+ * which sets badbit on the stream, so output loops checking the stream stop early.
+ **/
+class bounded_stringbuf
+   :  public std::streambuf
+{
+   private:
+      std::string& _str;
+      std::size_t  _max;
+      bool         _truncated = false;
+
+   protected:
+      int_type overflow(int_type c) override
       {
-         if(type != assertion_type::comp_zero)
+         if(traits_type::eq_int_type(c, traits_type::eof()))
          {
-            ulps[i] = numeric::float_ulps(lhs[i], rhs[i]);
+            return traits_type::not_eof(c);
          }
-         else
+         char ch = traits_type::to_char_type(c);
+         return this->xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+      }
+
+      std::streamsize xsputn(const char* s, std::streamsize n) override
+      {
+         auto size = static_cast<std::size_t>(n);
+         if(_max && _str.size() + size > _max)
          {
-            ulps[i] = numeric::float_ulps(lhs[i], lhs[i] + rhs[i]);
+            size       = _max - _str.size();
+            _truncated = true;
          }
+         _str.append(s, size);
+         return static_cast<std::streamsize>(size);
       }
-      return ulps;
-   }
 
-   static constexpr auto precision = std::numeric_limits<typename std::decay_t<T>::value_type>::max_digits10;
+   public:
+      bounded_stringbuf(std::string& str, std::size_t max)
+         :  _str(str)
+         ,  _max(max)
+      {
+      }
+
+      bool truncated() const
+      {
+         return _truncated;
+      }
 };
 
+template<class V>
+void set_value_format(std::ostream& os)
+{
+   os << std::left << std::scientific << std::boolalpha;
+   if constexpr(has_distance<V, V>::value)
+   {
+      os << std::setprecision(has_distance<V, V>::precision);
+   }
+}
+
+/**
+ * Render 'count' bytes of string from 'first', noting how much is left out.
+ **/
+inline std::string string_window(std::string_view str, std::size_t first, std::size_t count)
+{
+   first = first < str.size() ? first : str.size();
+   auto last = (count && count < str.size() - first) ? first + count : str.size();
+
+   std::string result;
+   if(first)
+   {
+      result += "... " + std::to_string(first) + " bytes ... ";
+   }
+   result.append(str.data() + first, last - first);
+   if(last < str.size())
+   {
+      result += " ... " + std::to_string(str.size() - last) + " more bytes";
+   }
+   return result;
+}
+
 /**
- * Print got
+ * Render 'count' elements of range from 'first', noting how many are left out.
+ **/
+template<class V>
+std::string range_window(const V& v, std::size_t first, std::size_t count)
+{
+   using value_type = sized_range_value_t<V>;
+   auto size = static_cast<std::size_t>(std::size(v));
+   first = first < size ? first : size;
+   auto last = (count && count < size - first) ? first + count : size;
+
+   std::string result;
+   bounded_stringbuf buf(result, rendering()._max_bytes);
+   std::ostream os(&buf);
+   set_value_format<value_type>(os);
+
+   os << "(";
+   if(first)
+   {
+      os << "... " << first << " elements, ";
+   }
+   auto iter = std::next(std::begin(v), static_cast<std::ptrdiff_t>(first));
+   for(auto i = first; i < last && os; ++i, ++iter)
+   {
+      os << *iter;
+      if(i + 1 < last)
+      {
+         os << ", ";
+      }
+   }
+   if(last < size)
+   {
+      os << ", ... " << (size - last) << " more";
+   }
+   os << ")";
+   if(buf.truncated())
+   {
+      result += " ... (truncated)";
+   }
+   return result;
+}
+
+/**
+ * Can value be rendered as a range of elements.
+ **/
+template<class V>
+constexpr bool is_renderable_range()
+{
+   if constexpr(is_sized_range_v<V> && !is_string_like_v<V>)
+   {
+      return exists_operator_output<sized_range_value_t<V> >::value;
+   }
+   else
+   {
+      return false;
+   }
+}
+
+/**
+ * Print got. The output is bounded by rendering() limits.
+ * Ranges of printable elements are printed element by element, also without an output operator for the range.
  **/
 template
    <  class V 
-   ,  std::enable_if_t<detail::exists_operator_output<V>::value, void*> = nullptr
+   ,  std::enable_if_t<detail::exists_operator_output<V>::value || is_renderable_range<V>(), void*> = nullptr
    >
 std::string value_string(const V& v)
 {
-   std::stringstream s_str;
-   s_str << std::left << std::scientific << std::boolalpha;
-   if constexpr(has_distance<V, V>::value)
+   if constexpr(is_string_like_v<V>)
    {
-      s_str << std::setprecision(has_distance<V, V>::precision);
+      return string_window(std::string_view(v), 0, rendering()._max_bytes);
+   }
+   else if constexpr(is_renderable_range<V>())
+   {
+      return range_window(v, 0, rendering()._max_elements);
+   }
+   else
+   {
+      std::string result;
+      bounded_stringbuf buf(result, rendering()._max_bytes);
+      std::ostream os(&buf);
+      set_value_format<V>(os);
+      os << v;
+      if(buf.truncated())
+      {
+         result += " ... (truncated)";
+      }
+      return result;
    }
-   s_str << v;
-   return s_str.str();
 }
 
 template
    <  class V
-   ,  std::enable_if_t<!detail::exists_operator_output<V>::value, void*> = nullptr
+   ,  std::enable_if_t<!detail::exists_operator_output<V>::value && !is_renderable_range<V>(), void*> = nullptr
    >
 std::string value_string(const V& v)
 { 
@@ -192,6 +361,249 @@ std::string value_string(const V& v)
    return s_str.str();
 }
 
+/**
+ * Check if an assertion passes on the result of its comparison (ulp_compare_result as fourth argument).
+ **/
+template<class... Ts>
+constexpr bool has_compare_result()
+{
+   if constexpr(sizeof...(Ts) >= 4)
+   {
+      return numeric::is_ulp_compare_result_v<remove_cvref_t<std::tuple_element_t<3, std::tuple<Ts...> > > >;
+   }
+   else
+   {
+      return false;
+   }
+}
+
+/**
+ * Check if the first difference of two values can be found and shown:
+ * both are strings, or both are ranges of comparable (and printable) elements.
+ **/
+template<class L, class R>
+constexpr bool is_diffable()
+{
+   if constexpr(is_string_like_v<L> && is_string_like_v<R>)
+   {
+      return true;
+   }
+   else if constexpr(is_renderable_range<L>() && is_renderable_range<R>())
+   {
+      return std::is_convertible_v<decltype(std::declval<const sized_range_value_t<L>&>() == std::declval<const sized_range_value_t<R>&>()), bool>;
+   }
+   else
+   {
+      return false;
+   }
+}
+
+/**
+ * Get index of the first difference of two strings or ranges (the smaller size if one is a prefix of the other).
+ **/
+template<class L, class R>
+std::size_t first_difference(const L& lhs, const R& rhs)
+{
+   if constexpr(is_string_like_v<L>)
+   {
+      std::string_view l(lhs), r(rhs);
+      auto n = l.size() < r.size() ? l.size() : r.size();
+      std::size_t i = 0;
+      while(i < n && l[i] == r[i])
+      {
+         ++i;
+      }
+      return i;
+   }
+   else
+   {
+      auto li = std::begin(lhs), le = std::end(lhs);
+      auto ri = std::begin(rhs), re = std::end(rhs);
+      std::size_t i = 0;
+      while(li != le && ri != re && *li == *ri)
+      {
+         ++li;
+         ++ri;
+         ++i;
+      }
+      return i;
+   }
+}
+
+/**
+ * Size of string or range, compared with limits to decide if a value is shown whole.
+ **/
+template<class V>
+std::size_t rendered_size(const V& v)
+{
+   if constexpr(is_string_like_v<V>)
+   {
+      return std::string_view(v).size();
+   }
+   else
+   {
+      return static_cast<std::size_t>(std::size(v));
+   }
+}
+
+/**
+ * Render single element of a range.
+ **/
+template<class T>
+std::string element_string(const T& t)
+{
+   std::string result;
+   bounded_stringbuf buf(result, rendering()._max_bytes);
+   std::ostream os(&buf);
+   set_value_format<T>(os);
+   os << t;
+   return result;
+}
+
+/**
+ * Split string into lines (without the newlines).
+ **/
+inline std::vector<std::string_view> split_lines(std::string_view str)
+{
+   std::vector<std::string_view> lines;
+   std::size_t pos = 0;
+   while(pos <= str.size())
+   {
+      auto end = str.find('\n', pos);
+      if(end == std::string_view::npos)
+      {
+         end = str.size();
+      }
+      lines.emplace_back(str.substr(pos, end - pos));
+      pos = end + 1;
+   }
+   return lines;
+}
+
+/**
+ * Diff two single-line strings as one hunk ('-' expected, '+' got): the bytes between their common prefix
+ * and common suffix, with up to rendering()._string_window bytes of context. Positions are byte indices.
+ **/
+inline std::string diff_line(std::string_view expected, std::string_view got)
+{
+   const auto& limits = rendering();
+   auto prefix = first_difference(expected, got);
+   auto common = (expected.size() < got.size() ? expected.size() : got.size()) - prefix;
+   std::size_t suffix = 0;
+   while(suffix < common && expected[expected.size() - 1 - suffix] == got[got.size() - 1 - suffix])
+   {
+      ++suffix;
+   }
+
+   auto first = prefix > limits._string_window ? prefix - limits._string_window : 0;
+   auto side  = [&limits, first, suffix](std::string_view str)
+   {
+      auto last  = str.size() - suffix + limits._string_window;
+      auto count = (last < str.size() ? last : str.size()) - first;
+      if(limits._max_bytes && count > limits._max_bytes)
+      {
+         count = limits._max_bytes;
+      }
+      return string_window(str, first, count);
+   };
+   return "@@ -" + std::to_string(prefix) + "," + std::to_string(expected.size() - prefix - suffix)
+        + " +"   + std::to_string(prefix) + "," + std::to_string(got.size() - prefix - suffix) + " @@\n"
+        + "- " + side(expected) + "\n"
+        + "+ " + side(got) + "\n";
+}
+
+/**
+ * Diff two strings by lines (by bytes if both are single lines) or two ranges by elements,
+ * rendered as hunks ('-' expected, '+' got).
+ * Returns empty string if the cutoffs of rendering()._diff were hit.
+ **/
+template<class E, class G>
+std::string diff_string(const E& expected, const G& got)
+{
+   const auto& limits = rendering();
+   std::vector<diff::edit> script;
+   if constexpr(is_string_like_v<E>)
+   {
+      if(std::string_view(expected).find('\n') == std::string_view::npos && std::string_view(got).find('\n') == std::string_view::npos)
+      {
+         return diff_line(expected, got);
+      }
+      auto lhs = split_lines(std::string_view(expected));
+      auto rhs = split_lines(std::string_view(got));
+      if(!diff::compute(lhs.size(), rhs.size(), [&lhs, &rhs](std::size_t i, std::size_t j) { return lhs[i] == rhs[j]; }, script, limits._diff))
+      {
+         return std::string{};
+      }
+      auto line = [&limits](const std::vector<std::string_view>& lines)
+      {
+         return [&lines, &limits](std::size_t i) { return string_window(lines[i], 0, limits._max_bytes); };
+      };
+      return diff::render_hunks(script, line(lhs), line(rhs), limits._diff_context, limits._max_bytes);
+   }
+   else
+   {
+      // Elements are accessed by index, through iterators collected first unless they are random access
+      auto access = [](const auto& range)
+      {
+         using iterator = decltype(std::begin(range));
+         if constexpr(std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<iterator>::iterator_category>)
+         {
+            return [begin = std::begin(range)](std::size_t i) -> decltype(auto) { return *(begin + static_cast<std::ptrdiff_t>(i)); };
+         }
+         else
+         {
+            std::vector<iterator> iters;
+            iters.reserve(static_cast<std::size_t>(std::size(range)));
+            for(auto iter = std::begin(range); iter != std::end(range); ++iter)
+            {
+               iters.emplace_back(iter);
+            }
+            return [iters = std::move(iters)](std::size_t i) -> decltype(auto) { return *iters[i]; };
+         }
+      };
+      auto lhs = access(expected);
+      auto rhs = access(got);
+      auto n   = static_cast<std::size_t>(std::size(expected));
+      auto m   = static_cast<std::size_t>(std::size(got));
+      if(!diff::compute(n, m, [&lhs, &rhs](std::size_t i, std::size_t j) { return static_cast<bool>(lhs(i) == rhs(j)); }, script, limits._diff))
+      {
+         return std::string{};
+      }
+      return diff::render_hunks
+         (  script
+         ,  [&lhs](std::size_t i) { return element_string(lhs(i)); }
+         ,  [&rhs](std::size_t j) { return element_string(rhs(j)); }
+         ,  limits._diff_context
+         ,  limits._max_bytes
+         ,  0
+         );
+   }
+}
+
+/**
+ * Render string or range around index 'diff' of the first difference.
+ **/
+template<class V>
+std::string value_window(const V& v, std::size_t diff)
+{
+   const auto& limits = rendering();
+   if constexpr(is_string_like_v<V>)
+   {
+      auto first = diff > limits._string_window ? diff - limits._string_window : 0;
+      return string_window(std::string_view(v), first, 2 * limits._string_window);
+   }
+   else
+   {
+      auto first = diff > limits._window ? diff - limits._window : 0;
+      auto count = 2 * limits._window + 1;
+      if(limits._max_elements && count > limits._max_elements)
+      {
+         count = limits._max_elements;
+      }
+      return range_window(v, first, count);
+   }
+}
+
 template<class V>
 std::string type_string(const V& v)
 {
@@ -205,74 +617,68 @@ struct message
 {
    enum format : int { fancy, raw };
    static const int short_width = 13;
-   
-   struct variable_triad
-   {
-      variable_triad(std::string&& label, std::string&& value, std::string&& type)
-         :  _label(std::move(label))
-         ,  _value(std::move(value))
-         ,  _type (std::move(type))
-      {
-      }
-
-      std::string _label;
-      std::string _value;
-      std::string _type ;
-   };
+   static const std::size_t max_aligned_width = 48;
 
    /**
-    * Generate fancy message
+    * Describe failed assertion: message, source location and the values involved.
     **/
    template<class... Ts>
-   static std::string __generate_message(const assertion<Ts...>& asrt)
+   static failure_event describe(const assertion<Ts...>& asrt)
    {
-      std::string tab = "   ";
-      std::stringstream s_str;
-      s_str << std::left << std::setprecision(16) << std::scientific << std::boolalpha; 
-      s_str << tab << std::setw(short_width) << "error" << "[/warning_color]" << asrt._info._message << "[/default_color]"
-            << "\n"
-            << tab << std::setw(short_width) << "file"  
-            << "[/file_color]";
-      if(!asrt._info._file.empty())
-      {
-         s_str << asrt._info._file << ":" << asrt._info._line;
-      }
-      else
-      {
-         s_str << "N/A";
-      }
-      s_str << "[/default_color]"
-            << "\n\n";
-      
+      failure_event event;
+      event._message = asrt._info._message;
+      event._file    = asrt._info._file;
+      event._line    = asrt._info._line;
 
-      std::vector<variable_triad> variable_vec;
+      auto& values = event._values;
 
       if constexpr(sizeof...(Ts) == 1)
       {
-         variable_vec.emplace_back
-            (  std::string{"value"} + std::string{(asrt._info._type == assertion_type::not_equal ? " not" : "")}
-            ,  detail::value_string(std::get<0>(asrt._args))
-            ,  detail::type_string (std::get<0>(asrt._args))
+         values.emplace_back
+            (  failure_event::value
+               {  std::string{"value"} + std::string{(asrt._info._type == assertion_type::not_equal ? " not" : "")}
+               ,  detail::value_string(std::get<0>(asrt._args))
+               ,  detail::type_string (std::get<0>(asrt._args))
+               }
             );
       }
 
+      if constexpr(sizeof...(Ts) == 2)
+      {
+         using got_type      = remove_cvref_t<std::tuple_element_t<0, std::tuple<Ts...> > >;
+         using expected_type = remove_cvref_t<std::tuple_element_t<1, std::tuple<Ts...> > >;
+         if constexpr(detail::is_diffable<got_type, expected_type>())
+         {
+            // Show only a window around the first difference of long strings and ranges
+            if(asrt._info._type == assertion_type::equal && describe_difference(asrt, values))
+            {
+               event._text = render(event);
+               return event;
+            }
+         }
+      }
+
       if constexpr(sizeof...(Ts) >= 2)
       {
-         variable_vec.emplace_back
-            (  (  asrt._info._type != assertion_type::comp_zero 
-               ?  std::string{"expected"} + std::string{(asrt._info._type == assertion_type::not_equal ? " not" : "")}
-               :  std::string{"compare"}
-               )
-            ,  detail::value_string(std::get<1>(asrt._args))
-            ,  detail::type_string (std::get<1>(asrt._args))
+         values.emplace_back
+            (  failure_event::value
+               {  (  asrt._info._type != assertion_type::comp_zero 
+                  ?  std::string{"expected"} + std::string{(asrt._info._type == assertion_type::not_equal ? " not" : "")}
+                  :  std::string{"compare"}
+                  )
+               ,  detail::value_string(std::get<1>(asrt._args))
+               ,  detail::type_string (std::get<1>(asrt._args))
+               }
             );
-         variable_vec.emplace_back
-            (  (  asrt._info._type != assertion_type::comp_zero
-               ?  std::string{"got"}
-               :  std::string{"zero"}
-               )
-            ,  detail::value_string(std::get<0>(asrt._args))
-            ,  detail::type_string (std::get<0>(asrt._args))
+         values.emplace_back
+            (  failure_event::value
+               {  (  asrt._info._type != assertion_type::comp_zero
+                  ?  std::string{"got"}
+                  :  std::string{"zero"}
+                  )
+               ,  detail::value_string(std::get<0>(asrt._args))
+               ,  detail::type_string (std::get<0>(asrt._args))
+               }
             );
       }
 
@@ -281,30 +687,155 @@ struct message
          using distance = detail::has_distance<decltype(std::get<1>(asrt._args)), decltype(std::get<0>(asrt._args))>;
          if constexpr (distance::value)
          {
-            auto dist = distance::calculate_distance(std::get<1>(asrt._args), std::get<0>(asrt._args), asrt._info._type);
+            auto dist = [&asrt]()
+            {
+               // Use the result of the comparison if the assertion passed it on (multi-threaded compare of huge ranges)
+               if constexpr(detail::has_compare_result<Ts...>())
+               {
+                  return numeric::make_ulp_report(std::get<1>(asrt._args), std::get<0>(asrt._args), std::get<2>(asrt._args), std::get<3>(asrt._args));
+               }
+               else
+               {
+                  return distance::calculate_distance(std::get<1>(asrt._args), std::get<0>(asrt._args), asrt._info._type, std::get<2>(asrt._args));
+               }
+            }();
             
-            variable_vec.emplace_back
-               (  std::string{"precision"}
-               ,  detail::value_string(std::get<2>(asrt._args))
-               ,  detail::type_string(std::get<2>(asrt._args))
+            values.emplace_back
+               (  failure_event::value
+                  {  std::string{"precision"}
+                  ,  detail::value_string(std::get<2>(asrt._args))
+                  ,  detail::type_string(std::get<2>(asrt._args))
+                  }
                );
 
-            variable_vec.emplace_back
-               (  std::string{"distance"}
-               ,  detail::value_string(dist)
-               ,  detail::type_string(dist)
+            values.emplace_back
+               (  failure_event::value
+                  {  std::string{"distance"}
+                  ,  detail::value_string(dist)
+                  ,  detail::type_string(dist)
+                  }
                );
          }
       }
 
+      event._text = render(event);
+      return event;
+   }
+
+   /**
+    * Describe the difference of two strings or ranges. Long ones are shown as a window around the first difference,
+    * and a diff is added for long ones and for multi-line strings (unless the diff cutoffs are hit).
+    * Returns false (describing nothing) for short single-line strings and short ranges, which are shown whole.
+    **/
+   template<class... Ts>
+   static bool describe_difference(const assertion<Ts...>& asrt, std::vector<failure_event::value>& values)
+   {
+      const auto& got      = std::get<0>(asrt._args);
+      const auto& expected = std::get<1>(asrt._args);
+      const auto& limits   = detail::rendering();
+
+      constexpr bool is_string = is_string_like_v<remove_cvref_t<decltype(got)> >;
+      auto limit = is_string ? limits._max_bytes : limits._max_elements;
+      auto size  = std::max(detail::rendered_size(got), detail::rendered_size(expected));
+      bool is_long = limit != 0 && size > limit;
+
+      bool multi_line = false;
+      if constexpr(is_string)
+      {
+         multi_line = std::string_view(got).find('\n') != std::string_view::npos || std::string_view(expected).find('\n') != std::string_view::npos;
+      }
+      if(!is_long && !multi_line)
+      {
+         return false;
+      }
+
+      // Diffing is only done here, on the failure path
+      auto hunks = detail::diff_string(expected, got);
+      auto diff  = detail::first_difference(got, expected);
+      values.emplace_back
+         (  failure_event::value
+            {  std::string{"expected"}
+            ,  is_long ? detail::value_window(expected, diff) : detail::value_string(expected)
+            ,  detail::type_string(expected)
+            }
+         );
+      values.emplace_back
+         (  failure_event::value
+            {  std::string{"got"}
+            ,  is_long ? detail::value_window(got, diff) : detail::value_string(got)
+            ,  detail::type_string(got)
+            }
+         );
+      values.emplace_back
+         (  failure_event::value
+            {  std::string{"first diff"}
+            ,  std::string{is_string ? "byte " : "element "} + std::to_string(diff)
+                  + " (sizes " + std::to_string(detail::rendered_size(expected)) + " and " + std::to_string(detail::rendered_size(got)) + ")"
+            ,  std::string{"index"}
+            }
+         );
+      if(!hunks.empty())
+      {
+         values.emplace_back
+            (  failure_event::value
+               {  std::string{"diff"}
+               ,  std::move(hunks)
+               ,  std::string{is_string ? (multi_line ? "-expected +got, by line" : "-expected +got, by byte") : "-expected +got, by element"}
+               }
+            );
+      }
+      return true;
+   }
+
+   /**
+    * Generate fancy message for described failure
+    **/
+   static std::string render(const failure_event& event)
+   {
+      std::string tab = "   ";
+      std::stringstream s_str;
+      s_str << std::left << std::setprecision(16) << std::scientific << std::boolalpha; 
+      s_str << tab << std::setw(short_width) << "error" << "[/warning_color]" << event._message << "[/default_color]"
+            << "\n"
+            << tab << std::setw(short_width) << "file"  
+            << "[/file_color]";
+      if(!event._file.empty())
+      {
+         s_str << event._file << ":" << event._line;
+      }
+      else
+      {
+         s_str << "N/A";
+      }
+      s_str << "[/default_color]"
+            << "\n\n";
+
+      // Align on the short values, long ones (e.g. mismatch reports) are not padded
       std::size_t width = 0;
-      for(const auto& v : variable_vec)
+      for(const auto& v : event._values)
       {
-         width = (width > v._value.size()) ? width : v._value.size();
+         if(v._value.size() <= max_aligned_width && v._value.find('\n') == std::string::npos)
+         {
+            width = (width > v._value.size()) ? width : v._value.size();
+         }
       }
 
-      for(const auto& v : variable_vec)
+      for(const auto& v : event._values)
       {
+         // Multi-line values (e.g. diffs) are shown as a block below the label
+         if(v._value.find('\n') != std::string::npos)
+         {
+            s_str << tab << std::setw(short_width) << v._label << "[" << "[/type_color]" << v._type << "[/default_color]" << "]\n";
+            std::size_t pos = 0;
+            while(pos < v._value.size())
+            {
+               auto end = v._value.find('\n', pos);
+               end = (end == std::string::npos) ? v._value.size() : end;
+               s_str << tab << std::setw(short_width) << "" << "[/value_color]" << v._value.substr(pos, end - pos) << "[/default_color]" << "\n";
+               pos = end + 1;
+            }
+            continue;
+         }
          s_str << tab   << std::setw(short_width)  << v._label 
                         << "[/value_color]"        << std::setw(width)        << v._value << "[/default_color]"
                         << " "                     << "[" << "[/type_color]"  << v._type  << "[/default_color]" << "]\n";
@@ -319,7 +850,7 @@ struct message
    template<class... Ts>
    static std::string generate(const assertion<Ts...>& asrt)
    {
-      return __generate_message(asrt);
+      return describe(asrt)._text;
    }
 
 };
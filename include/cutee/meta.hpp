@@ -5,6 +5,8 @@
 #include <type_traits>
 #include <complex>
 #include <vector>
+#include <iterator>
+#include <string_view>
 
 namespace cutee
 {
@@ -105,6 +107,97 @@ struct is_vector<std::vector<T, U> >
 template<class T>
 constexpr auto is_vector_v = is_vector<T>::value;
 
+/**
+ * Remove reference and cv-qualifiers (std::remove_cvref_t is C++20).
+ * Unlike std::decay_t arrays are kept as arrays.
+ **/
+template<class T>
+using remove_cvref_t = std::remove_cv_t<std::remove_reference_t<T> >;
+
+/**
+ * Check if type is a contiguous range, i.e. has std::data() and std::size()
+ * (std::vector, std::array, C arrays, std::span, cutee::span, Eigen maps, ...).
+ **/
+template<class T, class Enable = void>
+struct is_contiguous_range
+   :  public std::false_type
+{
+};
+
+template<class T>
+struct is_contiguous_range
+   <  T
+   ,  std::void_t
+      <  decltype(std::data(std::declval<const T&>()))
+      ,  decltype(std::size(std::declval<const T&>()))
+      >
+   >
+   :  public std::is_pointer<decltype(std::data(std::declval<const T&>()))>
+{
+   using value_type = std::remove_cv_t<std::remove_pointer_t<decltype(std::data(std::declval<const T&>()))> >;
+};
+
+template<class T>
+constexpr auto is_contiguous_range_v = is_contiguous_range<T>::value;
+
+template<class T>
+using contiguous_range_value_t = typename is_contiguous_range<T>::value_type;
+
+/**
+ * Check if type is a sized range, i.e. has std::begin(), std::end() and std::size()
+ * (all standard containers, C arrays, spans, ...).
+ **/
+template<class T, class Enable = void>
+struct is_sized_range
+   :  public std::false_type
+{
+};
+
+template<class T>
+struct is_sized_range
+   <  T
+   ,  std::void_t
+      <  decltype(std::begin(std::declval<const T&>()))
+      ,  decltype(std::end  (std::declval<const T&>()))
+      ,  decltype(std::size (std::declval<const T&>()))
+      >
+   >
+   :  public std::true_type
+{
+   using value_type = remove_cvref_t<decltype(*std::begin(std::declval<const T&>()))>;
+};
+
+template<class T>
+constexpr auto is_sized_range_v = is_sized_range<T>::value;
+
+template<class T>
+using sized_range_value_t = typename is_sized_range<T>::value_type;
+
+/**
+ * Check if type is a string (anything convertible to std::string_view: std::string, char arrays, ...).
+ * Character pointers (and nullptr) are not, as they may be null and are compared as pointers.
+ **/
+template<class T>
+constexpr auto is_string_like_v = std::is_convertible_v<const T&, std::string_view> && !std::is_pointer_v<remove_cvref_t<T> > && !std::is_null_pointer_v<remove_cvref_t<T> >;
+
+/**
+ * Check if type is a contiguous range of floating point numbers.
+ **/
+template<class T, class Enable = void>
+struct is_float_range
+   :  public std::false_type
+{
+};
+
+template<class T>
+struct is_float_range<T, std::enable_if_t<is_contiguous_range_v<T> > >
+   :  public std::is_floating_point<contiguous_range_value_t<T> >
+{
+};
+
+template<class T>
+constexpr auto is_float_range_v = is_float_range<T>::value;
+
 /**
  * Type sink for defining void on template parameters
  **/
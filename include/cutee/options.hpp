@@ -0,0 +1,360 @@
+#pragma once
+#ifndef CUTEE_OPTIONS_HPP_INCLUDED
+#define CUTEE_OPTIONS_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <thread>
+
+#include "perf_counters.hpp"
+
+namespace cutee
+{
+
+/**
+ * Options controlling how a suite is run.
+ **/
+struct run_options
+{
+   //! Number of worker threads. 0 means one per hardware thread.
+   unsigned _jobs = 1;
+
+   //! Run only tests with names matching any of these glob patterns ('*' and '?').
+   std::vector<std::string> _filters;
+
+   //! Run only tests with names matching this regular expression (ECMAScript, searched).
+   std::string _regex = "";
+
+   //! Run only tests with any of these tags.
+   std::vector<std::string> _tags;
+
+   //! Do not run tests with any of these tags.
+   std::vector<std::string> _exclude_tags;
+
+   //! File with test durations from previous runs, used for scheduling. Empty for none.
+   //! Updated with the durations of this run, except in sharded runs (each shard only sees its own tests).
+   std::string _history_file = "";
+
+   //! Run only shard '_shard_index' (0-based) of '_shard_count' shards.
+   unsigned _shard_index = 0;
+   unsigned _shard_count = 1;
+
+   //! Balance shards by durations in history file instead of by name hash only.
+   //! The history file must be identical on all nodes, or they compute different plans and
+   //! tests are run twice or not at all. Sharded runs therefore never write the history file;
+   //! produce it with an unsharded run (or merge per-node results out of band) and distribute it.
+   bool _shard_balance = false;
+
+   //! Print the shard plan instead of running the tests.
+   bool _shard_plan = false;
+
+   //! Max number of failed soft assertions recorded per test. 0 means no limit.
+   std::size_t _max_failures = 0;
+
+   //! Capture stdout and stderr of each test, and show it only if the test fails.
+   //! With several workers only std::cout, std::cerr and std::clog are captured (a warning is printed).
+   bool _capture = false;
+
+   //! Max number of bytes of output captured per test.
+   std::size_t _capture_limit = 1024 * 1024;
+
+   //! Max number of bytes of a value, and elements of a range, shown in a failure message. 0 means no limit.
+   std::size_t _max_value_bytes    = 4096;
+   std::size_t _max_value_elements = 32;
+
+   //! Max number of bytes of failure messages per test and per suite run. 0 means no limit.
+   std::size_t _max_failure_bytes       = 64 * 1024;
+   std::size_t _max_suite_failure_bytes = 16 * 1024 * 1024;
+
+   //! Defaults for adaptive performance tests: seconds measured at least, seconds spent at most,
+   //! and target half width of the 95% confidence interval of the mean relative to the mean.
+   double _perf_min_time     = 0.1;
+   double _perf_max_time     = 10.0;
+   double _perf_target_error = 0.02;
+
+   //! Default number of warm-up iterations of performance tests (not part of the statistics).
+   unsigned _perf_warmup = 1;
+
+   //! Read hardware counters in all performance tests, with these extra raw events.
+   bool _perf_counters = false;
+   std::vector<counter_event> _perf_events;
+
+   //! File with baselines of performance tests. Empty for none.
+   //! Tests are compared against it, or it is rewritten with the results of this run if '_update_baseline' is set
+   //! (not in sharded runs, which only compare).
+   std::string _baseline_file = "";
+   bool        _update_baseline = false;
+
+   //! A performance test fails when slower than baseline at significance level '_baseline_alpha' (Mann-Whitney U)
+   //! and its median is at least '_baseline_min_effect' (relative) slower.
+   double _baseline_alpha      = 0.01;
+   double _baseline_min_effect = 0.05;
+
+   /**
+    * Get the number of workers to use for running 'ntests' tests.
+    **/
+   unsigned workers(std::size_t ntests) const
+   {
+      unsigned jobs = _jobs ? _jobs : std::thread::hardware_concurrency();
+      if(jobs == 0)
+      {
+         jobs = 1;
+      }
+      if(ntests < jobs)
+      {
+         jobs = ntests ? static_cast<unsigned>(ntests) : 1;
+      }
+      return jobs;
+   }
+
+   /**
+    * Parse options from the command line. Arguments not recognized are ignored,
+    * so the program can have its own arguments as well.
+    *
+    * Recognized:
+    *    --jobs N, --jobs=N, -j N, -jN
+    *    --filter GLOB, --filter=GLOB     (may be repeated)
+    *    --regex REGEX, --regex=REGEX
+    *    --tag TAG, --tag=TAG             (may be repeated)
+    *    --exclude-tag TAG, --exclude-tag=TAG (may be repeated)
+    *    --history FILE, --history=FILE
+    *    --shard I/N, --shard=I/N  (I is 0-based)
+    *    --shard-balance           (needs the same --history file on all nodes)
+    *    --shard-plan
+    *    --max-failures N, --max-failures=N
+    *    --capture
+    *    --capture-limit N, --capture-limit=N
+    *    --max-value-bytes N, --max-value-bytes=N
+    *    --max-value-elements N, --max-value-elements=N
+    *    --max-failure-bytes N, --max-failure-bytes=N
+    *    --max-suite-failure-bytes N, --max-suite-failure-bytes=N
+    *    --perf-min-time SECONDS, --perf-min-time=SECONDS
+    *    --perf-max-time SECONDS, --perf-max-time=SECONDS
+    *    --perf-target-error FRACTION, --perf-target-error=FRACTION
+    *    --perf-warmup N, --perf-warmup=N
+    *    --perf-counters
+    *    --perf-event NAME=CONFIG, --perf-event=NAME=CONFIG (raw event, may be repeated, implies --perf-counters)
+    *    --baseline FILE, --baseline=FILE
+    *    --update-baseline
+    *    --baseline-alpha P, --baseline-alpha=P
+    *    --baseline-min-effect FRACTION, --baseline-min-effect=FRACTION
+    **/
+   static run_options parse(int argc, char* argv[])
+   {
+      run_options opts;
+      for(int i = 1; i < argc; ++i)
+      {
+         std::string arg = argv[i];
+         std::string value;
+         if(arg == "--shard-balance")
+         {
+            opts._shard_balance = true;
+         }
+         else if(arg == "--shard-plan")
+         {
+            opts._shard_plan = true;
+         }
+         else if(arg == "--capture")
+         {
+            opts._capture = true;
+         }
+         else if(arg == "--perf-counters")
+         {
+            opts._perf_counters = true;
+         }
+         else if(arg == "--update-baseline")
+         {
+            opts._update_baseline = true;
+         }
+         else if(match(arg, "--jobs", "-j", argc, argv, i, value))
+         {
+            opts._jobs = static_cast<unsigned>(to_unsigned(value, "--jobs"));
+         }
+         else if(match(arg, "--filter", "", argc, argv, i, value))
+         {
+            opts._filters.emplace_back(value);
+         }
+         else if(match(arg, "--regex", "", argc, argv, i, value))
+         {
+            opts._regex = value;
+         }
+         else if(match(arg, "--tag", "", argc, argv, i, value))
+         {
+            opts._tags.emplace_back(value);
+         }
+         else if(match(arg, "--exclude-tag", "", argc, argv, i, value))
+         {
+            opts._exclude_tags.emplace_back(value);
+         }
+         else if(match(arg, "--history", "", argc, argv, i, value))
+         {
+            opts._history_file = value;
+         }
+         else if(match(arg, "--max-failures", "", argc, argv, i, value))
+         {
+            opts._max_failures = static_cast<std::size_t>(to_unsigned(value, "--max-failures"));
+         }
+         else if(match(arg, "--capture-limit", "", argc, argv, i, value))
+         {
+            opts._capture_limit = static_cast<std::size_t>(to_unsigned(value, "--capture-limit"));
+         }
+         else if(match(arg, "--max-value-bytes", "", argc, argv, i, value))
+         {
+            opts._max_value_bytes = static_cast<std::size_t>(to_unsigned(value, "--max-value-bytes"));
+         }
+         else if(match(arg, "--max-value-elements", "", argc, argv, i, value))
+         {
+            opts._max_value_elements = static_cast<std::size_t>(to_unsigned(value, "--max-value-elements"));
+         }
+         else if(match(arg, "--max-failure-bytes", "", argc, argv, i, value))
+         {
+            opts._max_failure_bytes = static_cast<std::size_t>(to_unsigned(value, "--max-failure-bytes"));
+         }
+         else if(match(arg, "--max-suite-failure-bytes", "", argc, argv, i, value))
+         {
+            opts._max_suite_failure_bytes = static_cast<std::size_t>(to_unsigned(value, "--max-suite-failure-bytes"));
+         }
+         else if(match(arg, "--perf-min-time", "", argc, argv, i, value))
+         {
+            opts._perf_min_time = to_positive(value, "--perf-min-time");
+         }
+         else if(match(arg, "--perf-max-time", "", argc, argv, i, value))
+         {
+            opts._perf_max_time = to_positive(value, "--perf-max-time");
+         }
+         else if(match(arg, "--perf-target-error", "", argc, argv, i, value))
+         {
+            opts._perf_target_error = to_positive(value, "--perf-target-error");
+         }
+         else if(match(arg, "--perf-warmup", "", argc, argv, i, value))
+         {
+            opts._perf_warmup = static_cast<unsigned>(to_unsigned(value, "--perf-warmup"));
+         }
+         else if(match(arg, "--perf-event", "", argc, argv, i, value))
+         {
+            counter_event event;
+            if(!counter_event::parse_raw(value, event))
+            {
+               throw std::invalid_argument("cutee: option '--perf-event' must be given as NAME=CONFIG.");
+            }
+            opts._perf_events.emplace_back(std::move(event));
+            opts._perf_counters = true;
+         }
+         else if(match(arg, "--baseline", "", argc, argv, i, value))
+         {
+            opts._baseline_file = value;
+         }
+         else if(match(arg, "--baseline-alpha", "", argc, argv, i, value))
+         {
+            opts._baseline_alpha = to_positive(value, "--baseline-alpha");
+         }
+         else if(match(arg, "--baseline-min-effect", "", argc, argv, i, value))
+         {
+            opts._baseline_min_effect = to_positive(value, "--baseline-min-effect");
+         }
+         else if(match(arg, "--shard", "", argc, argv, i, value))
+         {
+            auto slash = value.find('/');
+            if(slash == std::string::npos)
+            {
+               throw std::invalid_argument("cutee: option '--shard' must be given as I/N.");
+            }
+            opts._shard_index = static_cast<unsigned>(to_unsigned(value.substr(0, slash), "--shard"));
+            opts._shard_count = static_cast<unsigned>(to_unsigned(value.substr(slash + 1), "--shard"));
+            if(opts._shard_count == 0 || opts._shard_index >= opts._shard_count)
+            {
+               throw std::invalid_argument("cutee: option '--shard' requires 0 <= I < N.");
+            }
+         }
+      }
+      return opts;
+   }
+
+   private:
+      /**
+       * Match 'arg' against long option 'lng' (as "--opt=value" or "--opt value")
+       * or short option 'shrt' (as "-oN" or "-o value"). Short options take numbers only,
+       * so an attached value must be all digits, and e.g. "-junk" is not taken for "-j".
+       * On match the value is returned in 'value' and 'i' is advanced past a separate value argument.
+       **/
+      static bool match
+         (  const std::string& arg
+         ,  const std::string& lng
+         ,  const std::string& shrt
+         ,  int argc
+         ,  char* argv[]
+         ,  int& i
+         ,  std::string& value
+         )
+      {
+         auto next = [&]()
+         {
+            if(i + 1 >= argc)
+            {
+               throw std::invalid_argument("cutee: option '" + arg + "' requires a value.");
+            }
+            value = argv[++i];
+            return true;
+         };
+
+         if(arg == lng || (!shrt.empty() && arg == shrt))
+         {
+            return next();
+         }
+         if(arg.compare(0, lng.size() + 1, lng + "=") == 0)
+         {
+            value = arg.substr(lng.size() + 1);
+            return true;
+         }
+         bool attached = !shrt.empty() && arg.size() > shrt.size() && arg.compare(0, shrt.size(), shrt) == 0;
+         if(attached && arg.find_first_not_of("0123456789", shrt.size()) == std::string::npos)
+         {
+            value = arg.substr(shrt.size());
+            return true;
+         }
+         return false;
+      }
+
+      static unsigned long to_unsigned(const std::string& value, const char* option)
+      {
+         std::size_t pos = 0;
+         unsigned long result = 0;
+         try
+         {
+            result = std::stoul(value, &pos);
+         }
+         catch(const std::exception&)
+         {
+            pos = 0;
+         }
+         if(value.empty() || pos != value.size() || value[0] == '-')
+         {
+            throw std::invalid_argument(std::string{"cutee: invalid value '"} + value + "' for option '" + option + "'.");
+         }
+         return result;
+      }
+
+      static double to_positive(const std::string& value, const char* option)
+      {
+         std::size_t pos = 0;
+         double result = 0.0;
+         try
+         {
+            result = std::stod(value, &pos);
+         }
+         catch(const std::exception&)
+         {
+            pos = 0;
+         }
+         if(value.empty() || pos != value.size() || !(result > 0.0))
+         {
+            throw std::invalid_argument(std::string{"cutee: invalid value '"} + value + "' for option '" + option + "'.");
+         }
+         return result;
+      }
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_OPTIONS_HPP_INCLUDED */
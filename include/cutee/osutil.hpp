@@ -4,8 +4,16 @@
 
 #include <iostream>
 #include <typeinfo>
+#include <string>
+#include <atomic>
+#include <random>
 
 #include "meta.hpp"
+#include "typedef.hpp"
+
+#ifdef CUTEE_HAVE_POSIX
+#include <unistd.h>
+#endif /* CUTEE_HAVE_POSIX */
 
 /**
  * Demangling stuff
@@ -75,6 +83,21 @@ struct exists_operator_output_utilp
 };
 PRAGMA_POP
 
+/**
+ * Name of a temporary file in the same directory as 'path', for writing a file and then renaming it into place.
+ * Unique per process and call, so processes writing the same file do not overwrite each other's temporary file.
+ **/
+inline std::string temporary_path(const std::string& path)
+{
+   static std::atomic<unsigned long> counter{0};
+#ifdef CUTEE_HAVE_POSIX
+   auto process = static_cast<unsigned long>(::getpid());
+#else
+   static const auto process = static_cast<unsigned long>(std::random_device{}());
+#endif /* CUTEE_HAVE_POSIX */
+   return path + ".tmp." + std::to_string(process) + "." + std::to_string(counter++);
+}
+
 /**
  * Get demangled type as string
  **/
@@ -105,7 +128,8 @@ template
 std::ostream& operator<<(std::ostream& os, const ITERABLE& cont)
 {
    os << "(";
-   for(auto it = cont.begin(), end = cont.end(); it != end; )
+   // Stop when the stream fails, e.g. a bounded buffer is full
+   for(auto it = cont.begin(), end = cont.end(); it != end && os; )
    {
       os << *it;
       if (++it != end)
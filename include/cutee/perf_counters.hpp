@@ -0,0 +1,270 @@
+#pragma once
+#ifndef CUTEE_PERF_COUNTERS_HPP_INCLUDED
+#define CUTEE_PERF_COUNTERS_HPP_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <exception>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#define CUTEE_HAVE_PERF_EVENT 1
+#endif /* __linux__ */
+
+namespace cutee
+{
+
+/**
+ * Hardware event to count, as given to perf_event_open ('_type' is e.g. PERF_TYPE_RAW, '_config' the event code).
+ **/
+struct counter_event
+{
+   //! Type of raw (CPU specific) events, PERF_TYPE_RAW.
+   static constexpr std::uint32_t raw = 4;
+
+   std::string   _name;
+   std::uint32_t _type   = 0;
+   std::uint64_t _config = 0;
+
+   /**
+    * Parse raw event given as "NAME=CONFIG", e.g. "uops_retired=0x01c2". Returns false if malformed.
+    **/
+   static bool parse_raw(const std::string& spec, counter_event& event)
+   {
+      auto eq = spec.find('=');
+      if(eq == 0 || eq == std::string::npos || eq + 1 == spec.size())
+      {
+         return false;
+      }
+      std::size_t pos = 0;
+      try
+      {
+         event._config = std::stoull(spec.substr(eq + 1), &pos, 0);
+      }
+      catch(const std::exception&)
+      {
+         return false;
+      }
+      event._name = spec.substr(0, eq);
+      event._type = raw;
+      return pos == spec.size() - eq - 1;
+   }
+};
+
+/**
+ * Group of hardware performance counters of the calling thread (user space only), read with perf_event_open.
+ * Counts cycles, instructions, cache references and misses, branch misses, and any extra (e.g. raw) events.
+ * Events that cannot be opened are left out; if none can, 'available()' is false and 'error()' says why.
+ * All events of the group are counted together, so derived metrics such as IPC are consistent.
+ **/
+class perf_counters
+{
+   private:
+      struct counter
+      {
+         counter_event _event;
+         int           _fd     = -1;
+         std::uint64_t _id     = 0;
+      };
+
+      std::vector<counter>       _counters;
+      std::vector<std::string>   _skipped;   // events that could not be opened
+      std::string                _error;
+      std::vector<std::uint64_t> _buffer;    // preallocated read buffer
+
+#ifdef CUTEE_HAVE_PERF_EVENT
+      static int open_event(const counter_event& event, int group_fd)
+      {
+         perf_event_attr attr;
+         std::memset(&attr, 0, sizeof(attr));
+         attr.size           = sizeof(attr);
+         attr.type           = event._type;
+         attr.config         = event._config;
+         attr.disabled       = group_fd == -1 ? 1 : 0;
+         attr.exclude_kernel = 1;   // allowed with perf_event_paranoid <= 2
+         attr.exclude_hv     = 1;
+         attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+         return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+      }
+
+      static std::string paranoid()
+      {
+         std::string level;
+         std::ifstream("/proc/sys/kernel/perf_event_paranoid") >> level;
+         return level.empty() ? "unknown" : level;
+      }
+#endif /* CUTEE_HAVE_PERF_EVENT */
+
+   public:
+      explicit perf_counters(const std::vector<counter_event>& extra = {})
+      {
+#ifdef CUTEE_HAVE_PERF_EVENT
+         std::vector<counter_event> events
+            {  {"cycles",           PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}
+            ,  {"instructions",     PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}
+            ,  {"cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES}
+            ,  {"cache-misses",     PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}
+            ,  {"branch-misses",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+            };
+         events.insert(events.end(), extra.begin(), extra.end());
+
+         int leader_errno = 0;
+         for(const auto& event : events)
+         {
+            auto group_fd = _counters.empty() ? -1 : _counters.front()._fd;
+            auto fd = open_event(event, group_fd);
+            if(fd == -1)
+            {
+               if(_counters.empty() && !leader_errno)
+               {
+                  leader_errno = errno;
+               }
+               _skipped.emplace_back(event._name);
+               continue;
+            }
+            counter c;
+            c._event = event;
+            c._fd    = fd;
+            if(ioctl(fd, PERF_EVENT_IOC_ID, &c._id) == -1)
+            {
+               close(fd);
+               _skipped.emplace_back(event._name);
+               continue;
+            }
+            _counters.emplace_back(std::move(c));
+         }
+
+         if(_counters.empty())
+         {
+            _error = std::string{"perf_event_open failed ("} + std::strerror(leader_errno) + ", perf_event_paranoid = " + paranoid() + ")";
+         }
+         _buffer.resize(3 + 2 * _counters.size());
+#else
+         (void)extra;
+         _error = "hardware counters are only supported on Linux";
+#endif /* CUTEE_HAVE_PERF_EVENT */
+      }
+
+      perf_counters(const perf_counters&) = delete;
+      perf_counters& operator=(const perf_counters&) = delete;
+
+      ~perf_counters()
+      {
+#ifdef CUTEE_HAVE_PERF_EVENT
+         for(auto& c : _counters)
+         {
+            close(c._fd);
+         }
+#endif /* CUTEE_HAVE_PERF_EVENT */
+      }
+
+      bool available() const
+      {
+         return !_counters.empty();
+      }
+
+      //! Reason counters are not available.
+      const std::string& error() const
+      {
+         return _error;
+      }
+
+      //! Events that could not be opened (e.g. not supported by the CPU).
+      const std::vector<std::string>& skipped() const
+      {
+         return _skipped;
+      }
+
+      std::size_t size() const
+      {
+         return _counters.size();
+      }
+
+      //! Name of counter 'i'.
+      const std::string& name(std::size_t i) const
+      {
+         return _counters[i]._event._name;
+      }
+
+      //! Index of counter named 'name', or size() if it was not opened.
+      std::size_t find(const std::string& name) const
+      {
+         std::size_t i = 0;
+         while(i < _counters.size() && _counters[i]._event._name != name)
+         {
+            ++i;
+         }
+         return i;
+      }
+
+      //! Reset and start counting.
+      void start()
+      {
+#ifdef CUTEE_HAVE_PERF_EVENT
+         if(available())
+         {
+            auto leader = _counters.front()._fd;
+            ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+         }
+#endif /* CUTEE_HAVE_PERF_EVENT */
+      }
+
+      /**
+       * Stop counting and read the counts into 'counts' (one per counter, scaled up if the group
+       * was multiplexed). Returns false if the counts could not be read or the group never ran.
+       **/
+      bool stop(std::vector<std::uint64_t>& counts)
+      {
+         counts.assign(_counters.size(), 0);
+#ifdef CUTEE_HAVE_PERF_EVENT
+         if(!available())
+         {
+            return false;
+         }
+         auto leader = _counters.front()._fd;
+         ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+         // Layout: nr, time_enabled, time_running, then { value, id } per counter
+         auto bytes = static_cast<ssize_t>(_buffer.size() * sizeof(std::uint64_t));
+         if(::read(leader, _buffer.data(), static_cast<std::size_t>(bytes)) != bytes)
+         {
+            return false;
+         }
+         auto enabled = _buffer[1];
+         auto running = _buffer[2];
+         if(running == 0)
+         {
+            return false;
+         }
+         auto scale = double(enabled) / double(running);
+         for(std::size_t i = 0; i < _buffer[0] && i < _counters.size(); ++i)
+         {
+            auto value = _buffer[3 + 2 * i];
+            auto id    = _buffer[4 + 2 * i];
+            for(std::size_t j = 0; j < _counters.size(); ++j)
+            {
+               if(_counters[j]._id == id)
+               {
+                  counts[j] = static_cast<std::uint64_t>(double(value) * scale);
+                  break;
+               }
+            }
+         }
+         return true;
+#else
+         return false;
+#endif /* CUTEE_HAVE_PERF_EVENT */
+      }
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_PERF_COUNTERS_HPP_INCLUDED */
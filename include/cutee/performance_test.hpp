@@ -3,13 +3,100 @@
 #define CUTEE_PERFORMANCE_TEST_H_INCLUDED
 
 #include<iostream>
+#include<iomanip>
+#include<sstream>
+#include<array>
+#include<vector>
+#include<algorithm>
+#include<memory>
+#include<cstdint>
 
 #include "test.hpp"
 #include "timer.hpp"
+#include "statistics.hpp"
+#include "cache.hpp"
+#include "baseline.hpp"
+#include "exceptions.hpp"
+#include "perf_counters.hpp"
+#include "alloc.hpp"
 
 namespace cutee
 {
 
+/**
+ * Options for the number of iterations of a performance test.
+ * With '_iterations' set the test runs exactly that many times, otherwise it is adaptive:
+ * iterations are added until at least '_min_time' has been measured and the confidence interval
+ * of the mean is within '_target_relative_error', or until '_max_time' or '_max_iterations' is reached.
+ * Zero adaptive settings are taken from detail::performance_defaults() when the test runs.
+ *
+ * '_warmup' iterations are run before the measured ones and are not part of the statistics.
+ * With '_cold' the CPU caches are evicted after setup of each iteration (outside the timed region),
+ * for measuring first-touch instead of steady-state performance.
+ * With '_counters' hardware performance counters (see perf_counters) are read around each timed region,
+ * including the extra '_events'.
+ **/
+struct performance_options
+{
+   int         _iterations            = 0;     // fixed number of iterations, 0 for adaptive
+   std::size_t _min_iterations        = 0;
+   std::size_t _max_iterations        = 0;
+   double      _min_time              = 0.0;   // seconds measured (sum of timed iterations)
+   double      _max_time              = 0.0;   // seconds spent in total, including setup and teardown
+   double      _target_relative_error = 0.0;   // half width of 95% confidence interval relative to mean
+   int         _warmup                = -1;    // untimed iterations before measuring, -1 for default
+   bool        _cold                  = false; // evict caches before each iteration
+   bool        _counters              = false; // read hardware counters (also enabled by default settings)
+   std::vector<counter_event> _events;         // extra events to count (e.g. raw events)
+
+   //! Options for a fixed number of iterations ('iterations' <= 0 for adaptive).
+   static performance_options fixed(int iterations)
+   {
+      performance_options options;
+      options._iterations = std::max(iterations, 0);
+      return options;
+   }
+
+   //! Fill unset settings from 'defaults'.
+   performance_options merged(const performance_options& defaults) const
+   {
+      auto result = *this;
+      if(!result._min_iterations)        result._min_iterations        = defaults._min_iterations;
+      if(!result._max_iterations)        result._max_iterations        = defaults._max_iterations;
+      if(result._min_time <= 0.0)        result._min_time              = defaults._min_time;
+      if(result._max_time <= 0.0)        result._max_time              = defaults._max_time;
+      if(result._target_relative_error <= 0.0) result._target_relative_error = defaults._target_relative_error;
+      if(result._warmup < 0)             result._warmup                = defaults._warmup;
+      result._counters = result._counters || defaults._counters;
+      result._events.insert(result._events.end(), defaults._events.begin(), defaults._events.end());
+      return result;
+   }
+};
+
+namespace detail
+{
+
+/**
+ * Defaults for performance tests. Set from run_options by the suite before tests are run.
+ **/
+inline performance_options& performance_defaults()
+{
+   static performance_options defaults = []()
+   {
+      performance_options options;
+      options._min_iterations        = 5;
+      options._max_iterations        = 100000;
+      options._min_time              = 0.1;
+      options._max_time              = 10.0;
+      options._target_relative_error = 0.02;
+      options._warmup                = 1;
+      return options;
+   }();
+   return defaults;
+}
+
+} /* namespace detail */
+
 template<typename T>
 class performance_test
    :  public test_impl<T>      /* using inheritance for EBCO (empty base class optimization) */
@@ -17,47 +104,479 @@ class performance_test
    using underlying_type = test_impl<T>;
 
    private:
-      clock_timer m_timer;
-      int         m_ntimes;
+      using timer_type = multi_timer<clocks::steady, clocks::thread_cpu, clocks::process_cpu, clocks::tsc>;
+      using samples_type = std::vector<double>;
+
+      //! Why an adaptive run stopped adding iterations.
+      enum class stop_reason { fixed, converged, max_time, max_iterations };
+
+      //! What was done with the baseline of the test in the last run.
+      enum class baseline_state { none, recorded, missing, compared };
+
+      timer_type          m_timer;
+      performance_options m_options;
+      performance_options m_used;        // options with defaults filled in, for the last run
+      stop_reason         m_stop = stop_reason::fixed;
+      double              m_error = 0.0; // relative error of the wall clock mean when stopping
+      baseline_state      m_baseline = baseline_state::none;
+      baseline_comparison m_comparison;
+      std::size_t         m_evicted = 0; // bytes streamed per cache eviction in the last run (cold runs only)
+      //! Duration of each iteration in seconds, one buffer per clock (preallocated, so recording does not allocate).
+      std::array<samples_type, timer_type::size> m_samples;
+
+      //! Hardware counters, open while running only.
+      std::unique_ptr<perf_counters>          m_counters;
+      std::vector<std::string>                m_counter_names;
+      std::vector<std::vector<std::uint64_t>> m_counts;          // per counter, per iteration
+      std::vector<std::uint64_t>              m_count_buffer;
+      std::size_t                             m_uncounted = 0;   // iterations the counters could not be read for
+      std::string                             m_counter_error;   // why counters are unavailable
+      std::vector<std::string>                m_counter_skipped; // events that could not be opened
+
+      //! Heap allocations of each iteration (if counted, see alloc.hpp).
+      std::vector<alloc::counters>            m_allocations;
+
+      //! Open hardware counters for this run, if requested.
+      void open_counters()
+      {
+         m_counter_names.clear();
+         m_counts.clear();
+         m_uncounted = 0;
+         m_counter_error.clear();
+         m_counter_skipped.clear();
+         if(!m_used._counters)
+         {
+            return;
+         }
+
+         m_counters.reset(new perf_counters(m_used._events));
+         m_counter_error   = m_counters->error();
+         m_counter_skipped = m_counters->skipped();
+         if(!m_counters->available())
+         {
+            m_counters.reset();
+            return;
+         }
+         m_counts.resize(m_counters->size());
+         for(std::size_t i = 0; i < m_counters->size(); ++i)
+         {
+            m_counter_names.emplace_back(m_counters->name(i));
+            m_counts[i].reserve(m_samples[0].capacity());
+         }
+         m_count_buffer.reserve(m_counters->size());
+      }
+
+      //! Mean count per iteration of counter named 'name', or -1 if not counted.
+      double mean_count(const std::string& name) const
+      {
+         auto iter = std::find(m_counter_names.begin(), m_counter_names.end(), name);
+         if(iter == m_counter_names.end())
+         {
+            return -1.0;
+         }
+         const auto& counts = m_counts[static_cast<std::size_t>(iter - m_counter_names.begin())];
+         double sum = 0.0;
+         for(auto c : counts)
+         {
+            sum += double(c);
+         }
+         return counts.empty() ? -1.0 : sum / double(counts.size());
+      }
+
+      //! Run one timed iteration, and record it for each clock unless it is a warm-up iteration.
+      void iteration(bool record = true)
+      {
+         underlying_type::setup();
+
+         if(m_used._cold)
+         {
+            auto& evictor = cache::evictor::get();
+            evictor.evict();
+            m_evicted = evictor.size();
+         }
+
+         // Start counters and timer (counters outside the timed region)
+         if(m_counters)
+         {
+            m_counters->start();
+         }
+         auto allocations = alloc::thread_counters();
+         m_timer.start();
+
+         underlying_type::run(); // run the test
+
+         // Stop timer and counters
+         m_timer.stop();
+         allocations = alloc::thread_counters() - allocations;
+         bool counted = m_counters && m_counters->stop(m_count_buffer);
+         if(record)
+         {
+            m_timer.for_each([this](std::size_t i, const auto& timer) { m_samples[i].push_back(timer.tot_clocks_per_sec()); });
+            m_allocations.push_back(allocations);
+            if(counted)
+            {
+               for(std::size_t i = 0; i < m_counts.size(); ++i)
+               {
+                  m_counts[i].push_back(m_count_buffer[i]);
+               }
+            }
+            else if(m_counters)
+            {
+               ++m_uncounted;
+            }
+         }
+
+         underlying_type::teardown();
+      }
+
+      //! Should an adaptive run stop after 'n' iterations.
+      bool done(std::size_t n, const stats::running& wall, double elapsed)
+      {
+         if(n >= m_used._max_iterations)
+         {
+            m_stop = stop_reason::max_iterations;
+            return true;
+         }
+         if(elapsed >= m_used._max_time)
+         {
+            m_stop = stop_reason::max_time;
+            return true;
+         }
+         if(n >= m_used._min_iterations && wall.mean() * double(n) >= m_used._min_time && wall.relative_error() <= m_used._target_relative_error)
+         {
+            m_stop = stop_reason::converged;
+            return true;
+         }
+         return false;
+      }
+
+      //! Record or compare wall clock samples against the baseline, if baselines are used in this run.
+      //! Baselines are keyed by the registered name, as history and filters are.
+      void check_baseline()
+      {
+         m_baseline = baseline_state::none;
+         const auto name = underlying_type::registered_name() + " (performance)";
+         const auto& settings = detail::baselines();
+         if(!settings._store || m_samples[0].empty())
+         {
+            return;
+         }
+
+         if(settings._update)
+         {
+            settings._store->record(name, baseline_entry::from_samples(m_samples[0]));
+            m_baseline = baseline_state::recorded;
+            return;
+         }
+
+         baseline_entry entry;
+         if(!settings._store->find(name, entry))
+         {
+            m_baseline = baseline_state::missing;
+            return;
+         }
+         m_comparison = baseline_store::compare(entry, m_samples[0], settings._alpha, settings._min_effect);
+         m_baseline   = baseline_state::compared;
+         if(m_comparison._regression)
+         {
+            throw exception::performance_regression("performance regression against baseline\n" + this->message());
+         }
+      }
+
+      //! Report hardware counters per iteration, and derived metrics.
+      template<class Percent>
+      void counter_report(std::ostream& sstr, Percent percent) const
+      {
+         if(m_counter_names.empty())
+         {
+            sstr << " counters: unavailable (" << m_counter_error << ")" << std::endl;
+            return;
+         }
+
+         constexpr int width = 18;
+         sstr << " counters (per iteration, user space):" << std::endl
+              << std::left
+              << "   " << std::setw(width) << "event" << std::setw(width) << "mean" << std::setw(width) << "median" << "min" << std::endl;
+         for(std::size_t i = 0; i < m_counter_names.size(); ++i)
+         {
+            std::vector<double> counts(m_counts[i].begin(), m_counts[i].end());
+            std::sort(counts.begin(), counts.end());
+            std::stringstream mean, median, min;
+            mean   << std::fixed << std::setprecision(1) << this->mean_count(m_counter_names[i]);
+            median << std::fixed << std::setprecision(0) << stats::percentile(counts, 0.5);
+            min    << std::fixed << std::setprecision(0) << (counts.empty() ? 0.0 : counts.front());
+            sstr << "   " << std::setw(width) << m_counter_names[i]
+                 << std::setw(width) << (counts.empty() ? "-" : mean.str())
+                 << std::setw(width) << median.str()
+                 << min.str()
+                 << std::endl;
+         }
+
+         auto cycles       = this->mean_count("cycles");
+         auto instructions = this->mean_count("instructions");
+         auto references   = this->mean_count("cache-references");
+         auto misses       = this->mean_count("cache-misses");
+         auto branches     = this->mean_count("branch-misses");
+         std::vector<std::string> derived;
+         if(cycles > 0.0 && instructions >= 0.0)
+         {
+            std::stringstream d;
+            d << "IPC " << std::fixed << std::setprecision(2) << instructions / cycles;
+            derived.emplace_back(d.str());
+         }
+         if(references > 0.0 && misses >= 0.0)
+         {
+            derived.emplace_back("cache miss rate " + percent(misses / references));
+         }
+         if(instructions > 0.0 && branches >= 0.0)
+         {
+            std::stringstream d;
+            d << std::fixed << std::setprecision(2) << 1000.0 * branches / instructions << " branch misses per 1000 instructions";
+            derived.emplace_back(d.str());
+         }
+         if(!derived.empty())
+         {
+            sstr << "   ";
+            for(std::size_t i = 0; i < derived.size(); ++i)
+            {
+               sstr << (i ? ", " : "") << derived[i];
+            }
+            sstr << std::endl;
+         }
+         if(!m_counter_skipped.empty())
+         {
+            sstr << "   not counted (could not be opened):";
+            for(const auto& name : m_counter_skipped)
+            {
+               sstr << " " << name;
+            }
+            sstr << std::endl;
+         }
+         if(m_uncounted)
+         {
+            sstr << "   " << m_uncounted << " iterations not counted (counters could not be read or were not scheduled)" << std::endl;
+         }
+      }
 
    public:
       template<class... Ts>
-      performance_test(int ntimes, Ts&&... ts)
+      performance_test(const performance_options& options, Ts&&... ts)
          :  underlying_type(std::forward<Ts>(ts)...)
          ,  m_timer()
-         ,  m_ntimes(ntimes)
+         ,  m_options(options)
+         ,  m_used(options)
       { 
+         // Adaptive runs reserve an initial chunk and grow between iterations (outside the timed region)
+         auto reserve = m_options._iterations > 0 ? std::size_t(m_options._iterations) : std::size_t(1024);
+         for(auto& samples : m_samples)
+         {
+            samples.reserve(reserve);
+         }
+         m_allocations.reserve(reserve);
+      }
+
+      template<class... Ts>
+      performance_test(int ntimes, Ts&&... ts)
+         :  performance_test(performance_options::fixed(ntimes), std::forward<Ts>(ts)...)
+      {
       }
 
       virtual void run() override
       { 
-         // Run test 
-         for(size_t i = 0; i < this->m_ntimes; ++i) // loop over repeats
+         for(auto& samples : m_samples)
          {
-            underlying_type::setup();
+            samples.clear();
+         }
+         m_allocations.clear();
 
-            // Start timer 
-            m_timer.start();
+         m_used = m_options.merged(detail::performance_defaults());
+         this->open_counters();
+         auto begin = clocks::steady::now();
 
-            underlying_type::run(); // run the test
+         // Warm up (page faults, lazy initialization, caches), not part of the statistics
+         for(int i = 0; i < m_used._warmup; ++i)
+         {
+            this->iteration(false);
+         }
+         m_timer.reset();
 
-            // Start timer 
-            m_timer.stop();
+         if(m_options._iterations > 0)
+         {
+            m_stop = stop_reason::fixed;
 
-            underlying_type::teardown();
+            // Run test 
+            for(int i = 0; i < m_options._iterations; ++i) // loop over repeats
+            {
+               this->iteration();
+            }
          }
+         else
+         {
+            stats::running wall;
+            do
+            {
+               this->iteration();
+               wall.add(m_samples[0].back());
+            }
+            while(!this->done(m_samples[0].size(), wall, clocks::steady::seconds(clocks::steady::now() - begin)));
+            m_error = wall.relative_error();
+         }
+         m_counters.reset();
+
+         this->check_baseline();
+      }
+
+      //! Per iteration durations in seconds for clock number 'clock' (in the order of timer_type).
+      const samples_type& samples(std::size_t clock = 0) const
+      {
+         return m_samples[clock];
+      }
+
+      //! Heap allocations of each iteration (all zero unless counted, see alloc.hpp).
+      const std::vector<alloc::counters>& allocations() const
+      {
+         return m_allocations;
+      }
+
+      //! Summary statistics for clock number 'clock' (wall clock by default).
+      stats::summary statistics(std::size_t clock = 0) const
+      {
+         return stats::summarize(m_samples[clock]);
       }
 
       virtual std::string message() const override
       {
+         auto percent = [](double fraction)
+         {
+            std::stringstream p;
+            p << std::fixed << std::setprecision(2) << 100.0 * fraction << "%";
+            return p.str();
+         };
+
          std::stringstream sstr;
 
          sstr << " TEST: " << this->name() << "\n"
-              << " did "   << m_ntimes << " runs and"
-              << " used: " << m_timer.tot_clocks() << " clocks "
-              << " (in "   << m_timer.tot_clocks_per_sec() << "s)."
+              << " did "   << m_samples[0].size() << " runs and"
+              << " used: " << m_timer.report() << "."
+              << std::endl;
+
+         if(m_used._warmup > 0)
+         {
+            sstr << " warm-up: " << m_used._warmup << " iterations (not measured)" << std::endl;
+         }
+         if(m_used._cold)
+         {
+            sstr << " cold: caches evicted before each iteration (streaming " << m_evicted / (1024 * 1024) << " MiB)" << std::endl;
+         }
+
+         if(m_stop != stop_reason::fixed)
+         {
+            sstr << " iterations: " << m_samples[0].size() << " (adaptive, ";
+            switch(m_stop)
+            {
+               case stop_reason::converged:
+                  sstr << "relative error " << percent(m_error) << " within target " << percent(m_used._target_relative_error);
+                  break;
+               case stop_reason::max_time:
+                  sstr << "time budget of " << stats::format_duration(m_used._max_time) << " reached at relative error " << percent(m_error);
+                  break;
+               case stop_reason::max_iterations:
+                  sstr << "max " << m_used._max_iterations << " iterations reached at relative error " << percent(m_error);
+                  break;
+               default:
+                  break;
+            }
+            sstr << ")" << std::endl;
+         }
+
+         constexpr int width = 12;
+         sstr << std::left
+              << "   " << std::setw(width) << "clock"
+              << std::setw(width) << "mean"
+              << std::setw(width) << "median"
+              << std::setw(width) << "min"
+              << std::setw(width) << "stddev"
+              << std::setw(width) << "MAD"
+              << std::setw(width) << "p90"
+              << std::setw(width) << "p99"
+              << "95% CI of mean"
               << std::endl;
 
+         stats::summary wall;
+         m_timer.for_each
+            (  [this, &sstr, &wall](std::size_t i, const auto& timer)
+               {
+                  auto s = this->statistics(i);
+                  if(i == 0)
+                  {
+                     wall = s;
+                  }
+                  sstr << "   " << std::setw(width) << timer.name()
+                       << std::setw(width) << stats::format_duration(s._mean)
+                       << std::setw(width) << stats::format_duration(s._median)
+                       << std::setw(width) << stats::format_duration(s._min)
+                       << std::setw(width) << stats::format_duration(s._stddev)
+                       << std::setw(width) << stats::format_duration(s._mad)
+                       << std::setw(width) << stats::format_duration(s._p90)
+                       << std::setw(width) << stats::format_duration(s._p99)
+                       << "[" << stats::format_duration(s._ci_low) << ", " << stats::format_duration(s._ci_high) << "]"
+                       << std::endl;
+               }
+            );
+
+         const auto& o = wall._outliers;
+         sstr << " outliers (" << timer_type::template name<0>() << "): " << o.total() << " of " << wall._count;
+         if(o.total())
+         {
+            sstr << " (" << o._low_severe << " low severe, " << o._low_mild << " low mild, "
+                 << o._high_mild << " high mild, " << o._high_severe << " high severe)";
+         }
+         sstr << std::endl;
+
+         if(m_used._counters)
+         {
+            this->counter_report(sstr, percent);
+         }
+
+         if(alloc::tracking() && !m_allocations.empty())
+         {
+            std::uint64_t total = 0, bytes = 0, most = 0;
+            for(const auto& a : m_allocations)
+            {
+               total += a._allocations;
+               bytes += a._bytes;
+               most   = std::max(most, a._allocations);
+            }
+            auto n = double(m_allocations.size());
+            std::stringstream mean, mean_bytes;
+            mean       << std::fixed << std::setprecision(1) << double(total) / n;
+            mean_bytes << std::fixed << std::setprecision(1) << double(bytes) / n;
+            sstr << " allocations per iteration: mean " << mean.str()
+                 << ", max " << most << " (mean " << mean_bytes.str() << " bytes)" << std::endl;
+         }
+
+         const auto& settings = detail::baselines();
+         switch(m_baseline)
+         {
+            case baseline_state::recorded:
+               sstr << " baseline: recorded" << std::endl;
+               break;
+            case baseline_state::missing:
+               sstr << " baseline: none recorded for this test" << std::endl;
+               break;
+            case baseline_state::compared:
+               sstr << " baseline: median " << stats::format_duration(m_comparison._baseline_median)
+                    << " -> " << stats::format_duration(m_comparison._median)
+                    << " (" << (m_comparison._change >= 0.0 ? "+" : "") << percent(m_comparison._change) << ")"
+                    << ", Mann-Whitney U p = " << m_comparison._test._p
+                    << " (alpha " << settings._alpha << ", min effect " << percent(settings._min_effect) << "): "
+                    << (m_comparison._regression ? "REGRESSION" : "no significant slowdown")
+                    << std::endl;
+               break;
+            default:
+               break;
+         }
+
          return sstr.str();
       }
 
@@ -67,6 +586,16 @@ class performance_test
       }
 };
 
+//
+template
+   <  class T
+   ,  typename... Args
+   >
+test_ptr_t create_performance_test(const performance_options& options, const std::string& a_name, Args&&... args)
+{
+   return test_ptr_t{ new performance_test<T>(options, a_name, std::forward<Args>(args)...) };
+}
+
 //
 template
    <  class T
@@ -0,0 +1,142 @@
+#pragma once
+#ifndef CUTEE_RING_BUFFER_HPP_INCLUDED
+#define CUTEE_RING_BUFFER_HPP_INCLUDED
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace cutee
+{
+
+/**
+ * Bounded lock-free multi-producer single-consumer ring buffer.
+ *
+ * Each slot carries a sequence number telling whether it is free for the push at a given position
+ * (sequence == position) or holds the value pushed there (sequence == position + 1).
+ * Producers claim a position with compare-and-swap on the head, so a full buffer is detected
+ * without locking and the caller can decide how to wait. Capacity is rounded up to a power of two.
+ **/
+template<class T>
+class ring_buffer
+{
+   private:
+      struct slot
+      {
+         std::atomic<std::size_t> _sequence;
+         T                        _value;
+      };
+
+      std::unique_ptr<slot[]>               _slots;
+      std::size_t                           _mask;
+      alignas(64) std::atomic<std::size_t>  _head{0};   // next position to push
+      alignas(64) std::atomic<std::size_t>  _tail{0};   // next position to pop
+
+      static std::size_t round_up(std::size_t capacity)
+      {
+         std::size_t size = 2;
+         while(size < capacity)
+         {
+            size <<= 1;
+         }
+         return size;
+      }
+
+   public:
+      explicit ring_buffer(std::size_t capacity)
+         :  _slots(new slot[round_up(capacity)])
+         ,  _mask (round_up(capacity) - 1)
+      {
+         for(std::size_t i = 0; i <= _mask; ++i)
+         {
+            _slots[i]._sequence.store(i, std::memory_order_relaxed);
+         }
+      }
+
+      ring_buffer(const ring_buffer&) = delete;
+      ring_buffer& operator=(const ring_buffer&) = delete;
+
+      /**
+       * Push value. Can be called from any thread. Returns false (leaving 'value' untouched) if full.
+       **/
+      bool try_push(T&& value)
+      {
+         std::size_t pos = _head.load(std::memory_order_relaxed);
+         for(;;)
+         {
+            slot& s = _slots[pos & _mask];
+            std::size_t seq = s._sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if(diff == 0)
+            {
+               if(_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+               {
+                  s._value = std::move(value);
+                  s._sequence.store(pos + 1, std::memory_order_release);
+                  return true;
+               }
+            }
+            else if(diff < 0)
+            {
+               return false;
+            }
+            else
+            {
+               pos = _head.load(std::memory_order_relaxed);
+            }
+         }
+      }
+
+      /**
+       * Pop value. Must only be called from the consumer thread. Returns false if empty.
+       **/
+      bool try_pop(T& value)
+      {
+         std::size_t pos = _tail.load(std::memory_order_relaxed);
+         slot& s = _slots[pos & _mask];
+         if(s._sequence.load(std::memory_order_acquire) != pos + 1)
+         {
+            return false;
+         }
+         value = std::move(s._value);
+         s._sequence.store(pos + _mask + 1, std::memory_order_release);
+         _tail.store(pos + 1, std::memory_order_release);
+         return true;
+      }
+
+      /**
+       * Visit values not yet popped, without removing them. Does not lock or allocate,
+       * but races with the consumer, so only meant for emergencies (e.g. from a signal handler).
+       **/
+      template<class F>
+      void peek(F&& f) const
+      {
+         std::size_t pos = _tail.load(std::memory_order_acquire);
+         for(std::size_t n = 0; n <= _mask; ++n, ++pos)
+         {
+            const slot& s = _slots[pos & _mask];
+            if(s._sequence.load(std::memory_order_acquire) != pos + 1)
+            {
+               break;
+            }
+            f(s._value);
+         }
+      }
+
+      bool empty() const
+      {
+         std::size_t pos = _tail.load(std::memory_order_acquire);
+         return _slots[pos & _mask]._sequence.load(std::memory_order_acquire) != pos + 1;
+      }
+
+      std::size_t capacity() const
+      {
+         return _mask + 1;
+      }
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_RING_BUFFER_HPP_INCLUDED */
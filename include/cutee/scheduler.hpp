@@ -0,0 +1,281 @@
+#pragma once
+#ifndef CUTEE_SCHEDULER_HPP_INCLUDED
+#define CUTEE_SCHEDULER_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <cmath>
+#include <unordered_map>
+
+#include "osutil.hpp"
+
+namespace cutee
+{
+
+/**
+ * Durations of tests recorded in previous runs.
+ *
+ * Stored on disk as one "<seconds>\t<test name>" line per test.
+ **/
+class test_history
+{
+   private:
+      std::unordered_map<std::string, double> _durations;
+
+   public:
+      /**
+       * Load history from file. A missing or unreadable file gives an empty history.
+       **/
+      bool load(const std::string& path)
+      {
+         std::ifstream ifs(path);
+         if(!ifs)
+         {
+            return false;
+         }
+
+         std::string line;
+         while(std::getline(ifs, line))
+         {
+            auto tab = line.find('\t');
+            if(line.empty() || line[0] == '#' || tab == std::string::npos)
+            {
+               continue;
+            }
+            try
+            {
+               // Durations order tests, so NaN, infinite or negative ones are skipped as malformed
+               auto seconds = std::stod(line.substr(0, tab));
+               if(std::isfinite(seconds) && seconds >= 0.0)
+               {
+                  _durations[line.substr(tab + 1)] = seconds;
+               }
+            }
+            catch(const std::exception&)
+            {
+               // Skip malformed lines
+            }
+         }
+         return true;
+      }
+
+      /**
+       * Save history to file. Written to a uniquely named temporary file first and then renamed,
+       * so concurrent readers never see a partial file and concurrent writers do not mix their files.
+       **/
+      bool save(const std::string& path) const
+      {
+         auto tmp = detail::temporary_path(path);
+         {
+            std::ofstream ofs(tmp, std::ios::trunc);
+            if(!ofs)
+            {
+               return false;
+            }
+
+            // Sort by name to keep the file stable between runs
+            std::vector<const std::pair<const std::string, double>*> entries;
+            for(const auto& e : _durations)
+            {
+               entries.emplace_back(&e);
+            }
+            std::sort(entries.begin(), entries.end(), [](auto lhs, auto rhs) { return lhs->first < rhs->first; });
+
+            ofs << "# cutee test history\n";
+            ofs.precision(6);
+            for(const auto* e : entries)
+            {
+               ofs << std::scientific << e->second << "\t" << e->first << "\n";
+            }
+            if(!ofs)
+            {
+               ofs.close();
+               std::remove(tmp.c_str());
+               return false;
+            }
+         }
+         if(std::rename(tmp.c_str(), path.c_str()) != 0)
+         {
+            std::remove(tmp.c_str());
+            return false;
+         }
+         return true;
+      }
+
+      /**
+       * Get recorded duration of test, or nullptr if test has no history.
+       **/
+      const double* find(const std::string& name) const
+      {
+         auto iter = _durations.find(name);
+         return iter != _durations.end() ? &iter->second : nullptr;
+      }
+
+      /**
+       * Record duration of test. Averaged with the previous duration to damp noise.
+       **/
+      void record(const std::string& name, double seconds)
+      {
+         if(name.find('\n') != std::string::npos)
+         {
+            return;
+         }
+         auto iter = _durations.find(name);
+         if(iter != _durations.end())
+         {
+            iter->second = 0.5 * (iter->second + seconds);
+         }
+         else
+         {
+            _durations.emplace(name, seconds);
+         }
+      }
+
+      std::size_t size() const
+      {
+         return _durations.size();
+      }
+};
+
+/**
+ * Work-stealing scheduler for running tests on a number of workers.
+ *
+ * Tests are ordered longest-processing-time-first from their estimated durations,
+ * with tests without an estimate (infinite) first, and dealt round-robin to
+ * per-worker queues. Workers take from the front of their own queue, and when empty
+ * steal the longest waiting test from the other queues, which keeps the
+ * longest-first order across workers at the end of the run.
+ *
+ * Exclusive tests (e.g. performance tests, which must not share the machine with other tests)
+ * are held back, and only handed out after 'release_exclusive', when the other tests have finished.
+ **/
+class scheduler
+{
+   public:
+      using task_t = std::size_t;
+
+      static constexpr double unknown = std::numeric_limits<double>::infinity();
+
+   private:
+      struct queue
+      {
+         std::mutex          _mutex;
+         std::deque<task_t>  _tasks;
+      };
+
+      std::vector<double> _estimates;
+      std::vector<queue>  _queues;
+      std::vector<task_t> _exclusive;
+
+      bool pop(queue& q, task_t& task)
+      {
+         std::lock_guard<std::mutex> lock(q._mutex);
+         if(q._tasks.empty())
+         {
+            return false;
+         }
+         task = q._tasks.front();
+         q._tasks.pop_front();
+         return true;
+      }
+
+      bool steal(unsigned worker, task_t& task)
+      {
+         while(true)
+         {
+            // Find queue with the longest waiting test
+            queue* victim  = nullptr;
+            double longest = -1.0;
+            for(unsigned i = 1; i < _queues.size(); ++i)
+            {
+               auto& q = _queues[(worker + i) % _queues.size()];
+               std::lock_guard<std::mutex> lock(q._mutex);
+               if(!q._tasks.empty() && _estimates[q._tasks.front()] > longest)
+               {
+                  longest = _estimates[q._tasks.front()];
+                  victim  = &q;
+               }
+            }
+
+            if(!victim)
+            {
+               return false;
+            }
+
+            // The victim may have been emptied in the meantime, if so look again
+            if(pop(*victim, task))
+            {
+               return true;
+            }
+         }
+      }
+
+   public:
+      /**
+       * Create scheduler for tests with given estimated durations (seconds or 'unknown').
+       * Tasks marked in 'exclusive' (if given) are held back until 'release_exclusive'.
+       **/
+      scheduler(std::vector<double> estimates, unsigned nworkers, const std::vector<char>& exclusive = {})
+         :  _estimates(std::move(estimates))
+         ,  _queues(nworkers ? nworkers : 1)
+      {
+         auto order = longest_first(_estimates);
+         std::size_t dealt = 0;
+         for(auto task : order)
+         {
+            if(task < exclusive.size() && exclusive[task])
+            {
+               _exclusive.push_back(task);
+            }
+            else
+            {
+               _queues[dealt++ % _queues.size()]._tasks.push_back(task);
+            }
+         }
+      }
+
+      /**
+       * Hand the held back exclusive tasks to 'worker', to be run one at a time.
+       * Call when all workers have run out of tasks, and only 'worker' is to continue.
+       **/
+      void release_exclusive(unsigned worker)
+      {
+         std::lock_guard<std::mutex> lock(_queues[worker]._mutex);
+         _queues[worker]._tasks.insert(_queues[worker]._tasks.end(), _exclusive.begin(), _exclusive.end());
+         _exclusive.clear();
+      }
+
+      /**
+       * Get next task for worker. Returns false when no tasks are left.
+       **/
+      bool next(unsigned worker, task_t& task)
+      {
+         return pop(_queues[worker], task) || steal(worker, task);
+      }
+
+      /**
+       * Order task indices by descending estimate, keeping registration order for ties.
+       **/
+      static std::vector<task_t> longest_first(const std::vector<double>& estimates)
+      {
+         std::vector<task_t> order(estimates.size());
+         std::iota(order.begin(), order.end(), task_t{0});
+         std::stable_sort
+            (  order.begin()
+            ,  order.end()
+            ,  [&estimates](task_t lhs, task_t rhs) { return estimates[lhs] > estimates[rhs]; }
+            );
+         return order;
+      }
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_SCHEDULER_HPP_INCLUDED */
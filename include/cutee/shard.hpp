@@ -0,0 +1,153 @@
+#pragma once
+#ifndef CUTEE_SHARD_HPP_INCLUDED
+#define CUTEE_SHARD_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+
+#include "scheduler.hpp"
+
+namespace cutee
+{
+
+namespace detail
+{
+
+/**
+ * 64-bit FNV-1a hash. Used instead of std::hash as it must give the same
+ * value on every machine and standard library.
+ **/
+inline std::uint64_t fnv1a(const std::string& str)
+{
+   std::uint64_t hash = 14695981039346656037ull;
+   for(unsigned char c : str)
+   {
+      hash ^= c;
+      hash *= 1099511628211ull;
+   }
+   return hash;
+}
+
+} /* namespace detail */
+
+/**
+ * Assignment of tests to shards, for splitting one test binary over several machines.
+ *
+ * Without history each test goes to shard 'hash(name) % count', which only depends on
+ * the name of the test and is therefore stable when tests are added or removed.
+ * With history the tests are balanced greedily longest-first onto the least loaded shard.
+ * Tests without history are estimated by the mean of the known durations.
+ * All nodes must then use the same history file to get the same plan, which is why sharded
+ * runs do not update the history file.
+ **/
+struct shard_plan
+{
+   std::vector<unsigned> _shard;     // shard of each test
+   std::vector<double>   _estimate;  // estimated duration of each test (balanced plan only)
+   unsigned              _count    = 1;
+   bool                  _balanced = false;
+
+   shard_plan(const std::vector<std::string>& names, unsigned count, const test_history* history = nullptr)
+      :  _shard(names.size(), 0)
+      ,  _estimate(history ? names.size() : 0, 0.0)
+      ,  _count(count ? count : 1)
+      ,  _balanced(history != nullptr)
+   {
+      std::vector<std::uint64_t> hashes(names.size());
+      std::transform(names.begin(), names.end(), hashes.begin(), detail::fnv1a);
+
+      if(!history)
+      {
+         for(std::size_t i = 0; i < names.size(); ++i)
+         {
+            _shard[i] = static_cast<unsigned>(hashes[i] % _count);
+         }
+         return;
+      }
+
+      // Estimate durations
+      double known_sum = 0.0;
+      std::size_t known = 0;
+      for(std::size_t i = 0; i < names.size(); ++i)
+      {
+         if(auto duration = history->find(names[i]))
+         {
+            _estimate[i] = *duration;
+            known_sum   += *duration;
+            ++known;
+         }
+         else
+         {
+            _estimate[i] = -1.0;
+         }
+      }
+      double fallback = known ? known_sum / known : 1.0;
+      std::replace(_estimate.begin(), _estimate.end(), -1.0, fallback);
+
+      // Longest first, ties broken by hash so the plan does not depend on registration order
+      std::vector<std::size_t> order(names.size());
+      std::iota(order.begin(), order.end(), std::size_t{0});
+      std::sort
+         (  order.begin()
+         ,  order.end()
+         ,  [this, &hashes, &names](std::size_t lhs, std::size_t rhs)
+            {
+               if(_estimate[lhs] != _estimate[rhs]) return _estimate[lhs] > _estimate[rhs];
+               if(hashes[lhs]    != hashes[rhs]   ) return hashes[lhs]    < hashes[rhs];
+               return names[lhs] < names[rhs];
+            }
+         );
+
+      std::vector<double> load(_count, 0.0);
+      for(auto i : order)
+      {
+         auto shard = static_cast<unsigned>(std::min_element(load.begin(), load.end()) - load.begin());
+         _shard[i]    = shard;
+         load[shard] += _estimate[i];
+      }
+   }
+
+   /**
+    * Get indices of tests in shard, in registration order.
+    **/
+   std::vector<std::size_t> tests(unsigned shard) const
+   {
+      std::vector<std::size_t> result;
+      for(std::size_t i = 0; i < _shard.size(); ++i)
+      {
+         if(_shard[i] == shard)
+         {
+            result.emplace_back(i);
+         }
+      }
+      return result;
+   }
+
+   /**
+    * Get estimated duration of shard. Zero if plan is not balanced.
+    **/
+   double estimate(unsigned shard) const
+   {
+      double sum = 0.0;
+      for(std::size_t i = 0; i < _estimate.size(); ++i)
+      {
+         if(_shard[i] == shard)
+         {
+            sum += _estimate[i];
+         }
+      }
+      return sum;
+   }
+
+   bool balanced() const
+   {
+      return _balanced;
+   }
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_SHARD_HPP_INCLUDED */
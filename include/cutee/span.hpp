@@ -0,0 +1,67 @@
+#pragma once
+#ifndef CUTEE_SPAN_HPP_INCLUDED
+#define CUTEE_SPAN_HPP_INCLUDED
+
+#include <cstddef>
+
+namespace cutee
+{
+
+/**
+ * Non-owning view of a contiguous buffer, for asserting on raw pointers
+ * without copying the data (cutee is C++17, so std::span is not available).
+ **/
+template<class T>
+class span
+{
+   private:
+      T*          _data = nullptr;
+      std::size_t _size = 0;
+
+   public:
+      using value_type = T;
+      using iterator   = T*;
+
+      constexpr span() = default;
+
+      constexpr span(T* data, std::size_t size)
+         :  _data(data)
+         ,  _size(size)
+      {
+      }
+
+      constexpr T* data() const
+      {
+         return _data;
+      }
+
+      constexpr std::size_t size() const
+      {
+         return _size;
+      }
+
+      constexpr T& operator[](std::size_t i) const
+      {
+         return _data[i];
+      }
+
+      constexpr T* begin() const
+      {
+         return _data;
+      }
+
+      constexpr T* end() const
+      {
+         return _data + _size;
+      }
+};
+
+template<class T>
+constexpr span<T> make_span(T* data, std::size_t size)
+{
+   return span<T>(data, size);
+}
+
+} /* namespace cutee */
+
+#endif /* CUTEE_SPAN_HPP_INCLUDED */
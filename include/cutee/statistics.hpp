@@ -0,0 +1,296 @@
+#pragma once
+#ifndef CUTEE_STATISTICS_HPP_INCLUDED
+#define CUTEE_STATISTICS_HPP_INCLUDED
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace cutee
+{
+
+namespace stats
+{
+
+/**
+ * Outliers by Tukey's fences: mild outside 1.5 IQR, severe outside 3 IQR from the quartiles.
+ **/
+struct outliers
+{
+   std::size_t _low_severe  = 0;
+   std::size_t _low_mild    = 0;
+   std::size_t _high_mild   = 0;
+   std::size_t _high_severe = 0;
+
+   std::size_t total() const
+   {
+      return _low_severe + _low_mild + _high_mild + _high_severe;
+   }
+};
+
+/**
+ * Summary statistics of a set of samples (e.g. durations of benchmark iterations).
+ **/
+struct summary
+{
+   std::size_t _count   = 0;
+   double      _mean    = 0.0;
+   double      _median  = 0.0;
+   double      _min     = 0.0;
+   double      _max     = 0.0;
+   double      _stddev  = 0.0;   // sample standard deviation
+   double      _mad     = 0.0;   // median absolute deviation (unscaled)
+   double      _p90     = 0.0;
+   double      _p99     = 0.0;
+   double      _ci_low  = 0.0;   // bootstrap confidence interval of the mean
+   double      _ci_high = 0.0;
+   double      _confidence = 0.0;
+   outliers    _outliers;
+
+   //! Half width of the confidence interval relative to the mean.
+   double relative_error() const
+   {
+      return _mean != 0.0 ? (_ci_high - _ci_low) / (2.0 * std::fabs(_mean)) : 0.0;
+   }
+};
+
+/**
+ * Running mean and variance (Welford), cheap enough to update after every sample.
+ **/
+class running
+{
+   private:
+      std::size_t _count = 0;
+      double      _mean  = 0.0;
+      double      _m2    = 0.0;
+
+   public:
+      void add(double x)
+      {
+         ++_count;
+         auto delta = x - _mean;
+         _mean += delta / double(_count);
+         _m2   += delta * (x - _mean);
+      }
+
+      std::size_t count() const { return _count; }
+      double      mean()  const { return _mean; }
+
+      double stddev() const
+      {
+         return _count > 1 ? std::sqrt(_m2 / double(_count - 1)) : 0.0;
+      }
+
+      /**
+       * Half width of the normal approximation confidence interval of the mean ('z' standard errors)
+       * relative to the mean. Infinite for less than two samples.
+       **/
+      double relative_error(double z = 1.96) const
+      {
+         if(_count < 2 || _mean == 0.0)
+         {
+            return _count < 2 ? std::numeric_limits<double>::infinity() : 0.0;
+         }
+         return z * stddev() / std::sqrt(double(_count)) / std::fabs(_mean);
+      }
+};
+
+/**
+ * Percentile 'p' (in [0, 1]) of sorted samples, interpolating linearly between closest ranks.
+ **/
+inline double percentile(const std::vector<double>& sorted, double p)
+{
+   if(sorted.empty())
+   {
+      return 0.0;
+   }
+   auto pos   = p * double(sorted.size() - 1);
+   auto lower = static_cast<std::size_t>(pos);
+   auto upper = std::min(lower + 1, sorted.size() - 1);
+   return sorted[lower] + (pos - double(lower)) * (sorted[upper] - sorted[lower]);
+}
+
+/**
+ * Percentile bootstrap confidence interval of the mean. Resampling is seeded,
+ * so results are reproducible, and the number of resamples is reduced for large sample sets.
+ **/
+inline void bootstrap_mean(const std::vector<double>& samples, double confidence, double& low, double& high, std::size_t resamples = 1000)
+{
+   auto n = samples.size();
+   if(n < 2)
+   {
+      low = high = n ? samples[0] : 0.0;
+      return;
+   }
+   constexpr std::size_t max_draws = 10000000;
+   resamples = std::max<std::size_t>(100, std::min(resamples, max_draws / n));
+
+   std::mt19937_64 rng(0x5eed);
+   std::uniform_int_distribution<std::size_t> pick(0, n - 1);
+   std::vector<double> means(resamples);
+   for(auto& m : means)
+   {
+      double sum = 0.0;
+      for(std::size_t i = 0; i < n; ++i)
+      {
+         sum += samples[pick(rng)];
+      }
+      m = sum / double(n);
+   }
+   std::sort(means.begin(), means.end());
+   auto alpha = (1.0 - confidence) / 2.0;
+   low  = percentile(means, alpha);
+   high = percentile(means, 1.0 - alpha);
+}
+
+/**
+ * Compute summary of samples.
+ **/
+inline summary summarize(const std::vector<double>& samples, double confidence = 0.95)
+{
+   summary s;
+   s._count      = samples.size();
+   s._confidence = confidence;
+   if(samples.empty())
+   {
+      return s;
+   }
+
+   std::vector<double> sorted(samples);
+   std::sort(sorted.begin(), sorted.end());
+
+   auto n = double(sorted.size());
+   s._mean   = std::accumulate(sorted.begin(), sorted.end(), 0.0) / n;
+   s._median = percentile(sorted, 0.5);
+   s._min    = sorted.front();
+   s._max    = sorted.back();
+   s._p90    = percentile(sorted, 0.90);
+   s._p99    = percentile(sorted, 0.99);
+
+   double squares = 0.0;
+   for(auto x : sorted)
+   {
+      squares += (x - s._mean) * (x - s._mean);
+   }
+   s._stddev = sorted.size() > 1 ? std::sqrt(squares / (n - 1.0)) : 0.0;
+
+   std::vector<double> deviations(sorted.size());
+   std::transform(sorted.begin(), sorted.end(), deviations.begin(), [&s](double x) { return std::fabs(x - s._median); });
+   std::sort(deviations.begin(), deviations.end());
+   s._mad = percentile(deviations, 0.5);
+
+   auto q1  = percentile(sorted, 0.25);
+   auto q3  = percentile(sorted, 0.75);
+   auto iqr = q3 - q1;
+   for(auto x : sorted)
+   {
+      if     (x < q1 - 3.0 * iqr) ++s._outliers._low_severe;
+      else if(x < q1 - 1.5 * iqr) ++s._outliers._low_mild;
+      else if(x > q3 + 3.0 * iqr) ++s._outliers._high_severe;
+      else if(x > q3 + 1.5 * iqr) ++s._outliers._high_mild;
+   }
+
+   bootstrap_mean(samples, confidence, s._ci_low, s._ci_high);
+   return s;
+}
+
+/**
+ * Result of a Mann-Whitney U test.
+ **/
+struct rank_test
+{
+   double _u = 0.0;   // U statistic of the first sample
+   double _z = 0.0;   // normal approximation (tie and continuity corrected)
+   double _p = 1.0;   // one-sided p-value
+};
+
+/**
+ * One-sided Mann-Whitney U test of whether values of 'a' tend to be larger than values of 'b',
+ * using the normal approximation with tie correction (suitable for more than ~10 samples each).
+ **/
+inline rank_test mann_whitney_greater(const std::vector<double>& a, const std::vector<double>& b)
+{
+   rank_test result;
+   auto na = a.size();
+   auto nb = b.size();
+   if(na == 0 || nb == 0)
+   {
+      return result;
+   }
+
+   // Pool samples, tagging those from 'a', and rank them with average ranks for ties
+   std::vector<std::pair<double, bool> > pooled;
+   pooled.reserve(na + nb);
+   for(auto x : a) pooled.emplace_back(x, true);
+   for(auto x : b) pooled.emplace_back(x, false);
+   std::sort(pooled.begin(), pooled.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+   double rank_sum = 0.0;
+   double ties     = 0.0;
+   for(std::size_t i = 0; i < pooled.size(); )
+   {
+      auto j = i;
+      while(j < pooled.size() && pooled[j].first == pooled[i].first)
+      {
+         ++j;
+      }
+      auto rank = 0.5 * double(i + 1 + j);  // average of ranks i+1..j
+      for(auto k = i; k < j; ++k)
+      {
+         if(pooled[k].second)
+         {
+            rank_sum += rank;
+         }
+      }
+      auto t = double(j - i);
+      ties += t * t * t - t;
+      i = j;
+   }
+
+   auto n1 = double(na);
+   auto n2 = double(nb);
+   auto n  = n1 + n2;
+   result._u = rank_sum - n1 * (n1 + 1.0) / 2.0;
+
+   auto mean     = n1 * n2 / 2.0;
+   auto variance = n1 * n2 / 12.0 * ((n + 1.0) - ties / (n * (n - 1.0)));
+   if(variance <= 0.0)
+   {
+      return result;
+   }
+   result._z = (result._u - mean - 0.5) / std::sqrt(variance);
+   result._p = 0.5 * std::erfc(result._z / std::sqrt(2.0));
+   return result;
+}
+
+/**
+ * Format duration in seconds with a suitable unit, e.g. "12.35 us".
+ **/
+inline std::string format_duration(double seconds)
+{
+   const char* unit = "s";
+   auto value = seconds;
+   auto magnitude = std::fabs(seconds);
+   if     (magnitude == 0.0) { }
+   else if(magnitude < 1e-6) { value *= 1e9; unit = "ns"; }
+   else if(magnitude < 1e-3) { value *= 1e6; unit = "us"; }
+   else if(magnitude < 1.0)  { value *= 1e3; unit = "ms"; }
+
+   std::stringstream sstr;
+   sstr << std::fixed << std::setprecision(magnitude == 0.0 ? 0 : (std::fabs(value) < 10 ? 3 : (std::fabs(value) < 100 ? 2 : 1))) << value << " " << unit;
+   return sstr.str();
+}
+
+} /* namespace stats */
+
+} /* namespace cutee */
+
+#endif /* CUTEE_STATISTICS_HPP_INCLUDED */
@@ -3,13 +3,31 @@
 #define CUTEE_TEST_SUITE_HPP_INCLUDED
 
 #include <iostream>
-
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <chrono>
+#include <numeric>
+#include <memory>
+
+#include "typedef.hpp"
+#include "options.hpp"
+#include "scheduler.hpp"
+#include "shard.hpp"
+#include "filter.hpp"
 #include "test.hpp"
 #include "container.hpp"
 
 #include "timer.hpp"
 #include "exceptions.hpp"
 #include "message.hpp"
+#include "failure_buffer.hpp"
+#include "failure_queue.hpp"
+#include "capture.hpp"
+#include "event.hpp"
+#include "float_eq_par.hpp"
 #include "writer.hpp"
 
 namespace cutee
@@ -36,31 +54,120 @@ class suite
          this->_num_assertions = 0;
          this->_num_failed     = 0;
       }
+
+      counter& operator+=(const counter& other)
+      {
+         this->_num_tests      += other._num_tests;
+         this->_num_assertions += other._num_assertions;
+         this->_num_failed     += other._num_failed;
+         return *this;
+      }
+   };
+
+   /**
+    * Output of a single test. Buffered by the worker running the test,
+    * and written in test order when all preceding tests have finished.
+    **/
+   struct report
+   {
+      struct entry
+      {
+         bool        _failed;
+         std::string _message;
+      };
+
+      std::vector<entry>      _entries;
+      std::vector<test_event> _events;
+
+      void add(bool failed, std::string&& message)
+      {
+         _entries.emplace_back(entry{failed, std::move(message)});
+      }
+   };
+
+   /**
+    * State of the running test shared with threads started by the test (see cutee::thread).
+    * Threads add their assertion count and failures when they are done.
+    **/
+   struct shared_state
+   {
+      std::atomic<counter_type> _num_assertions{0};
+      failure_queue             _failures;
+   };
+
+   /**
+    * Limits on the size of failure messages, per test and for the whole run (0 for no limit).
+    **/
+   struct failure_budget
+   {
+      std::size_t              _max_test  = 0;
+      std::size_t              _max_suite = 0;
+      std::atomic<std::size_t> _used      {0};
+   };
+
+   /**
+    * State of a worker thread running tests, or of a thread adopted by a test.
+    **/
+   struct worker_context
+   {
+      counter<counter_type> _counter;
+      report*               _report  = nullptr;
+      failure_buffer        _soft;             // failed soft assertions of the running test
+      shared_state          _shared;
+      worker_context*       _owner   = nullptr; // context of the test for adopted threads
+      output_capture*       _capture = nullptr; // captures output of tests, if requested
+      failure_budget*       _budget  = nullptr; // limits on failure output
+   };
+
+   /**
+    * State shared by all workers during a single run.
+    **/
+   struct run_state
+   {
+      std::vector<std::size_t> _tests;
+      std::mutex               _mutex;
+      std::vector<report>      _reports;
+      std::vector<double>      _durations;
+      std::vector<char>        _done;
+      std::size_t              _next_flush = 0;
+      cutee::scheduler         _scheduler;
+      std::atomic<bool>        _stop       {false};
+      std::exception_ptr       _exception  = nullptr;
+      failure_budget           _budget;
+
+      run_state(std::vector<std::size_t>&& tests, std::vector<double>&& estimates, unsigned nworkers, const std::vector<char>& exclusive)
+         :  _tests    (std::move(tests))
+         ,  _reports  (_tests.size())
+         ,  _durations(_tests.size(), 0.0)
+         ,  _done     (_tests.size(), false)
+         ,  _scheduler(std::move(estimates), nworkers, exclusive)
+      {
+      }
    };
 
+   //! Wall clock is primary, as tests may run in parallel, and process CPU time is shown next to it.
+   using suite_timer = multi_timer<clocks::steady, clocks::process_cpu>;
+
    private:
       std::string            _name = "";
       counter<counter_type>  _counter;
-      clock_timer            _timer;
+      suite_timer            _timer;
       bool                   _first  = false;
       writer_ptr_t           _writer = writer_ptr_t{ nullptr };
+
+      //! Context of the worker running on this thread.
+      static Cutee_thread_local worker_context* _context;
       
       /* Create message strings */
-      std::string create_header_message()       const;
+      std::string create_header_message(const std::vector<std::size_t>&) const;
+      std::string create_shard_plan_message(const shard_plan&, const std::vector<std::string>&) const;
       std::string create_statistics_message()   const;
       std::string create_footer_message()       const;
       std::string create_test_message(const std::string& msg) const;
        
-      std::string create_failed_message(const std::string& name, const std::string& msg)
+      std::string create_failed_message(const std::string& name, const std::string& msg) const
       {
          std::stringstream sstr;
-         if(this->_first)
-         {
-            sstr << "----------------------------------------------------------------------\n"
-                 << "   FAILED TESTS:\n";
-            this->_first = false;
-         }
-
          sstr   << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n"
                 << "[/name_color]"<< "   *** " << name << " ***\n" << "[/default_color]"
                 << msg;
@@ -69,25 +176,70 @@ class suite
       }
 
       /**
-       * Execute assertion
+       * Execute assertion. The check is inlined and a passing assertion only does the accounting,
+       * everything else is left to fail_assertion (or record_failure for soft assertions).
        **/
-      template<class... Ts>
-      void execute_assertion(assertion<Ts...>&& asrt)
+      template<severity S = severity::fatal, class F, class I, class... Ts>
+      void execute_assertion(F&& check, I&& i, assertion_type type, Ts&&... ts)
       {
          // Do some accounting
-         _counter._num_assertions += 1;
+         _context->_counter._num_assertions += 1;
          
          // Perform assertion
-         if(!asrt.execute())
+         if(CUTEE_UNLIKELY(!check(ts...)))
+         {
+            if constexpr(S == severity::fatal)
+            {
+               this->fail_assertion(std::forward<I>(i), type, std::forward<Ts>(ts)...);
+            }
+            else
+            {
+               this->record_failure(std::forward<I>(i), type, std::forward<Ts>(ts)...);
+            }
+         }
+      }
+
+      /**
+       * Record failed soft assertion. The message is created when the test has finished.
+       * Past the max number of failures kept, the failure is only counted (its info is not created).
+       **/
+      template<class I, class... Ts>
+      CUTEE_NOINLINE void record_failure(I&& i, assertion_type type, Ts&&... ts)
+      {
+         alloc::suspend framework;
+         if(_context->_soft.drop())
          {
-            throw exception::assertion_failed(std::move(asrt));
+            return;
          }
+         _context->_soft.add(detail::materialize_info(std::forward<I>(i), type), std::forward<Ts>(ts)...);
+      }
+
+      /**
+       * Fail assertion. Only here is the message created.
+       **/
+      template<class I, class... Ts>
+      [[noreturn]] CUTEE_NOINLINE void fail_assertion(I&& i, assertion_type type, Ts&&... ts)
+      {
+         alloc::suspend framework;
+         throw exception::assertion_failed
+            (  assertion<Ts...>
+               {  std::forward_as_tuple(std::forward<Ts>(ts)...)
+               ,  detail::materialize_info(std::forward<I>(i), type)
+               }
+            );
       }
 
       friend struct asserter;
       friend class collection;
+      friend class test_context;
+      friend class context_guard;
+
+      void run_test(test_interface&, std::string_view);
+      void bound_failures(std::vector<failure_event>&) const;
 
-      void run_test(test_interface&);
+      std::vector<std::string> test_names();
+      void run_worker(run_state&, unsigned);
+      void write_report(const report&);
 
    public:
       /**
@@ -113,7 +265,7 @@ class suite
       /*!
        *
        */
-      bool do_tests(const writer&);
+      bool do_tests(const writer&, const run_options& = run_options{});
 
       /*!
        * Interface for running the test suite.
@@ -127,6 +279,11 @@ class suite
       {
          return this->do_tests(w);
       }
+      
+      bool run(const writer& w, const run_options& opts)
+      {
+         return this->do_tests(w, opts);
+      }
 };
 
 // For backwards compatibility
@@ -142,7 +299,7 @@ namespace cutee
 /**
  *
  **/
-inline std::string suite::create_header_message() const
+inline std::string suite::create_header_message(const std::vector<std::size_t>& tests) const
 {
    std::stringstream sstr;
    // output header
@@ -150,13 +307,50 @@ inline std::string suite::create_header_message() const
          << "======================================================================\n"
          << "   NAME: " << "[/name_color]" << this->_name << "[/default_color]" << "\n"
          << "----------------------------------------------------------------------\n"
-         << "   TESTS TO BE RUN: " << this->test_size() << "\n";
+         << "   TESTS TO BE RUN: " << tests.size() << "\n";
 
    // output tests that should be run
-   for(decltype(this->test_size()) i = 0; i < this->test_size(); ++i)
+   for(auto i : tests)
+   {
+      sstr << "      " << this->test_name(i) << "\n";
+   }
+
+   return sstr.str();
+}
+
+/**
+ *
+ **/
+inline std::string suite::create_shard_plan_message
+   (  const shard_plan&               plan
+   ,  const std::vector<std::string>& names
+   )  const
+{
+   std::stringstream sstr;
+   sstr  << "[/bold_on]"
+         << "======================================================================\n"
+         << "   NAME: " << "[/name_color]" << this->_name << "[/default_color]" << "\n"
+         << "----------------------------------------------------------------------\n"
+         << "   SHARD PLAN: " << names.size() << " tests in " << plan._count << " shards"
+         << (plan.balanced() ? " (balanced)" : "") << "\n";
+
+   for(unsigned shard = 0; shard < plan._count; ++shard)
    {
-      sstr << "      " << const_cast<suite*>(this)->get_test(i)->name() << "\n";
+      auto tests = plan.tests(shard);
+      sstr << "----------------------------------------------------------------------\n"
+           << "   SHARD " << shard << "/" << plan._count << ": " << tests.size() << " tests";
+      if(plan.balanced())
+      {
+         sstr << ", estimated " << plan.estimate(shard) << "s";
+      }
+      sstr << "\n";
+      for(auto i : tests)
+      {
+         sstr << "      " << names[i] << "\n";
+      }
    }
+   sstr  << "======================================================================\n"
+         << "[/bold_off]";
 
    return sstr.str();
 }
@@ -169,7 +363,7 @@ inline std::string suite::create_statistics_message() const
    std::stringstream sstr;
    sstr << "----------------------------------------------------------------------\n"
         << "   STATISTICS:\n"
-        << "      Finished tests in " << _timer.tot_clocks_per_sec()  << "s, "
+        << "      Finished tests in " << _timer.report()              << ", "
         << _counter._num_tests     /_timer.tot_clocks_per_sec()       << " tests/s, "
         << _counter._num_assertions/_timer.tot_clocks_per_sec()       << " assertions/s \n"
         << "      " 
@@ -204,52 +398,238 @@ inline std::string suite::create_test_message(const std::string& msg) const
 }
 
 /**
- *
+ * Run a single test registered as 'name'. Output is added to the report of the calling worker.
+ * Events use the registered name, as filters, shards and history do.
  **/
-inline void suite::run_test(test_interface& t)
+inline void suite::run_test(test_interface& t, std::string_view name)
 {
+   using clock = std::chrono::steady_clock;
+
+   auto& ctx = *_context;
+   auto  start = clock::now();
+   auto  num_assertions = ctx._counter._num_assertions;
+
+   test_event event;
+   event._name = std::string{name};
+
+   // Capture output of setup, run and teardown, if requested
+   output_capture::scope capture(ctx._capture);
+
    // Setup
+   alloc::begin_test();
    t.setup();
 
    // Run
+   std::vector<failure_event> fatal;
    try
    {
       t.run();
+      event._allocations = alloc::test_counters();
 
-      std::string message = t.message();
+      event._output = t.message();
 
-      if(!message.empty())
+      if(!event._output.empty())
       {
-         message = this->create_test_message(message);
-         this->_writer->write(message);
+         ctx._report->add(false, this->create_test_message(event._output));
       }
    }
+   catch(const exception::assertion_failed& e)
+   {
+      fatal.emplace_back(e._failure);
+   }
    catch(const exception::failed& e)
    {
-      this->_writer->write(this->create_failed_message(t.name(), e.what()));
-      _counter._num_failed += 1;
+      fatal.emplace_back(failure_event{e.what(), "", 0, {}, e.what()});
    }
    catch(const std::exception& e)
    {
-      std::string message = "   std::exception \n";
-      message += e.what();
-      message += "\n";
-      this->_writer->write(this->create_failed_message(t.name(), std::move(message)));
-      _counter._num_failed += 1;
+      std::string text = "   std::exception \n";
+      text += e.what();
+      text += "\n";
+      fatal.emplace_back(failure_event{std::string{"std::exception: "} + e.what(), "", 0, {}, std::move(text)});
    }
    catch(...)
    {
-      this->_writer->write(this->create_failed_message(t.name(), "   cutee::suite caught \"something\"...\n"));
-      _counter._num_failed += 1;
+      fatal.emplace_back(failure_event{"unknown exception", "", 0, {}, "   cutee::suite caught \"something\"...\n"});
+   }
+
+   // Soft assertion failures are described only now, and go before the failure that stopped the test (if any),
+   // followed by failures from threads started by the test
+   if(!ctx._soft.empty())
+   {
+      ctx._soft.collect(event._failures);
+      ctx._soft.clear();
+   }
+   ctx._counter._num_assertions += ctx._shared._num_assertions.exchange(0);
+   for(auto& failure : ctx._shared._failures.drain())
+   {
+      event._failures.emplace_back(std::move(failure));
+   }
+   for(auto& failure : fatal)
+   {
+      event._failures.emplace_back(std::move(failure));
    }
 
    // Count
-   _counter._num_tests += 1;
+   ctx._counter._num_tests += 1;
    
    // Teardown
    t.teardown();
+
+   // Captured output is only kept for failed tests
+   auto captured = capture.end();
+
+   if(!event._failures.empty())
+   {
+      this->bound_failures(event._failures);
+
+      std::string text;
+      for(std::size_t i = 0; i < event._failures.size(); ++i)
+      {
+         text += (i ? "\n" : "") + event._failures[i]._text;
+      }
+      if(!captured.empty())
+      {
+         text += "\n   [/bold_on]captured output[/bold_off]\n" + captured;
+         event._captured = std::move(captured);
+      }
+      ctx._report->add(true, this->create_failed_message(event._name, text));
+      ctx._counter._num_failed += 1;
+      event._failed = true;
+   }
+
+   event._num_assertions = ctx._counter._num_assertions - num_assertions;
+   event._duration       = std::chrono::duration<double>(clock::now() - start).count();
+   ctx._report->_events.emplace_back(std::move(event));
+}
+
+/**
+ * Keep failure messages of a test within the limits per test and per run.
+ * The first failure of a test is kept unless the limit of the run has been reached,
+ * and failures left out are replaced by a note.
+ **/
+inline void suite::bound_failures(std::vector<failure_event>& failures) const
+{
+   auto* budget = _context->_budget;
+   if(!budget)
+   {
+      return;
+   }
+
+   std::size_t bytes = 0;
+   std::size_t keep  = 0;
+   for(; keep < failures.size(); ++keep)
+   {
+      auto size = failures[keep]._text.size();
+      if(keep > 0 && budget->_max_test && bytes + size > budget->_max_test)
+      {
+         break;
+      }
+      bytes += size;
+   }
+
+   std::string note;
+   auto used = budget->_used.fetch_add(bytes, std::memory_order_relaxed);
+   if(budget->_max_suite && used + bytes > budget->_max_suite)
+   {
+      note = "   " + std::to_string(failures.size()) + " failures not shown (limit of " + std::to_string(budget->_max_suite) + " bytes of failure messages per run reached)\n";
+      keep = 0;
+   }
+   else if(keep < failures.size())
+   {
+      note = "   ... " + std::to_string(failures.size() - keep) + " more failures not shown (limit of " + std::to_string(budget->_max_test) + " bytes of failure messages per test)\n";
+   }
+
+   if(!note.empty())
+   {
+      failures.resize(keep);
+      failures.emplace_back(failure_event{"failure messages not shown", "", 0, {}, std::move(note)});
+   }
+}
+
+/**
+ * Write the output of a finished test. Must be called in test order.
+ **/
+inline void suite::write_report(const report& r)
+{
+   for(const auto& e : r._entries)
+   {
+      if(e._failed && this->_first)
+      {
+         this->_writer->write
+            (  "----------------------------------------------------------------------\n"
+               "   FAILED TESTS:\n"
+            );
+         this->_first = false;
+      }
+      this->_writer->write(e._message);
+   }
+   for(const auto& e : r._events)
+   {
+      this->_writer->test_finished(e);
+   }
+}
+
+/**
+ * Worker loop. Takes tests from the scheduler until none are left,
+ * and flushes finished reports in test order.
+ **/
+inline void suite::run_worker(run_state& state, unsigned worker)
+{
+   using clock = std::chrono::steady_clock;
+
+   asserter::__set_suite_ptr(this);
+   
+   scheduler::task_t i;
+   while(!state._stop.load(std::memory_order_relaxed) && state._scheduler.next(worker, i))
+   {
+      _context->_report = &state._reports[i];
+      auto start = clock::now();
+      try
+      {
+         // Create the test only now, and destroy it right after it has run
+         test_ptr_t holder;
+         this->run_test(this->acquire_test(state._tests[i], holder), this->test_name(state._tests[i]));
+      }
+      catch(...)
+      {
+         // Exception from setup or teardown, stop the run and rethrow on calling thread
+         std::lock_guard<std::mutex> lock(state._mutex);
+         if(!state._exception)
+         {
+            state._exception = std::current_exception();
+         }
+         state._stop = true;
+      }
+      _context->_report = nullptr;
+
+      std::lock_guard<std::mutex> lock(state._mutex);
+      state._durations[i] = std::chrono::duration<double>(clock::now() - start).count();
+      state._done[i] = true;
+      while(state._next_flush < state._tests.size() && state._done[state._next_flush])
+      {
+         this->write_report(state._reports[state._next_flush]);
+         state._reports[state._next_flush] = report{};
+         ++state._next_flush;
+      }
+   }
+   
+   asserter::__unset_suite_ptr();
 }
 
+/**
+ * Get names of all tests.
+ **/
+inline std::vector<std::string> suite::test_names()
+{
+   std::vector<std::string> names;
+   names.reserve(test_size());
+   for(decltype(test_size()) i = 0; i < test_size(); ++i)
+   {
+      names.emplace_back(this->test_name(i));
+   }
+   return names;
+}
 
 /**
  *
@@ -259,38 +639,239 @@ inline bool suite::do_tests
    ,  const cutee::format& form
    )
 {
-   auto w = writer_ptr_t{new formated_writer{os, form}};
-   return this->do_tests(*w);
+   formated_writer w{os, form};
+   return this->do_tests(w);
 }
 
 inline bool suite::do_tests
-   (  const writer& w
+   (  const writer&      w
+   ,  const run_options& opts
    )
 {
-   asserter::__set_suite_ptr(this);
+   auto names = this->test_names();
+
+   test_history history;
+   if(!opts._history_file.empty())
+   {
+      history.load(opts._history_file);
+   }
+
+   // Select tests by filter, before any of them are created
+   std::vector<std::size_t> tests;
+   test_filter filter(opts._filters, opts._regex, opts._tags, opts._exclude_tags);
+   for(decltype(test_size()) i = 0; i < test_size(); ++i)
+   {
+      if(filter.empty() || filter.accepts(this->test_name(i), this->test_tags(i)))
+      {
+         tests.emplace_back(i);
+      }
+   }
+
+   // Select tests of this shard
+   if(opts._shard_count > 1 || opts._shard_plan)
+   {
+      std::vector<std::string> selected_names;
+      selected_names.reserve(tests.size());
+      for(auto i : tests)
+      {
+         selected_names.emplace_back(names[i]);
+      }
+
+      shard_plan plan(selected_names, opts._shard_count, opts._shard_balance ? &history : nullptr);
+      if(opts._shard_plan)
+      {
+         w.write(this->create_shard_plan_message(plan, selected_names));
+         w.flush();
+         return true;
+      }
+
+      auto shard_tests = plan.tests(opts._shard_index);
+      for(auto& i : shard_tests)
+      {
+         i = tests[i];
+      }
+      tests = std::move(shard_tests);
+   }
+   
+   auto* suite_ptr = asserter::_suite_ptr;
    this->_counter.reset();
    this->_first  = true;
    this->_writer = &w; //
-   this->_writer->write(this->create_header_message());
+   this->_writer->write(this->create_header_message(tests));
+   this->_writer->begin_suite(suite_event{this->_name, tests.size()});
+
+   // Estimate test durations from history
+   std::vector<double> estimates(tests.size(), scheduler::unknown);
+   for(std::size_t i = 0; i < tests.size(); ++i)
+   {
+      if(auto duration = history.find(names[tests[i]]))
+      {
+         estimates[i] = *duration;
+      }
+   }
+
+   std::vector<worker_context> contexts(opts.workers(tests.size()));
+
+   // File descriptors can only be redirected when a single worker runs tests
+   std::unique_ptr<output_capture> capture;
+   if(opts._capture)
+   {
+      if(contexts.size() > 1)
+      {
+         std::cerr << "cutee: --capture with " << contexts.size() << " workers only captures std::cout, std::cerr and std::clog;"
+                   << " output written to file descriptors (printf, child processes) is not captured. Use --jobs 1 to capture it." << std::endl;
+      }
+      capture.reset(new output_capture(contexts.size() == 1, opts._capture_limit));
+   }
+
+   for(auto& ctx : contexts)
+   {
+      ctx._soft.set_max(opts._max_failures);
+      ctx._capture = capture.get();
+   }
+
+   // Performance tests are timed (and compared against baselines), so with several workers
+   // they are held back and run one at a time when all other tests have finished
+   std::vector<char> exclusive;
+   if(contexts.size() > 1)
+   {
+      exclusive.resize(tests.size());
+      for(std::size_t i = 0; i < tests.size(); ++i)
+      {
+         exclusive[i] = this->is_performance_test(tests[i]);
+      }
+   }
+
+   run_state state(std::move(tests), std::move(estimates), static_cast<unsigned>(contexts.size()), exclusive);
+   state._budget._max_test  = opts._max_failure_bytes;
+   state._budget._max_suite = opts._max_suite_failure_bytes;
+   for(auto& ctx : contexts)
+   {
+      ctx._budget = &state._budget;
+   }
+
+   // Parallel compares in tests share the hardware threads with the workers
+   auto outer_workers = numeric::detail::suite_workers();
+   numeric::detail::suite_workers() = static_cast<unsigned>(contexts.size());
+
+   // Bound rendering of values in failure messages (read by all workers, so set before they start)
+   detail::rendering()._max_bytes    = opts._max_value_bytes;
+   detail::rendering()._max_elements = opts._max_value_elements;
+
+   // Defaults for performance tests
+   detail::performance_defaults()._min_time              = opts._perf_min_time;
+   detail::performance_defaults()._max_time              = opts._perf_max_time;
+   detail::performance_defaults()._target_relative_error = opts._perf_target_error;
+   detail::performance_defaults()._warmup                = static_cast<int>(opts._perf_warmup);
+   detail::performance_defaults()._counters              = opts._perf_counters;
+   detail::performance_defaults()._events                = opts._perf_events;
+
+   // Baselines of performance tests. Not updated in sharded runs, as nodes would overwrite each other's entries.
+   baseline_store baselines;
+   auto outer_baselines = detail::baselines();
+   if(!opts._baseline_file.empty())
+   {
+      bool update = opts._update_baseline && opts._shard_count <= 1;
+      if(opts._update_baseline && !update)
+      {
+         std::cerr << "cutee: baselines are not updated in sharded runs, comparing against '" << opts._baseline_file << "' instead." << std::endl;
+      }
+      baselines.load(opts._baseline_file);
+      detail::baselines() = detail::baseline_settings{&baselines, update, opts._baseline_alpha, opts._baseline_min_effect};
+   }
    
    // Start timer
    _timer.start();
    
-   // Run tests
-   for(decltype(test_size()) i=0; i<test_size(); ++i)
+   // Run tests, the calling thread acts as the first worker
    {
-      this->run_test(*(get_test(i)));
+      std::vector<std::thread> threads;
+      for(std::size_t i = 1; i < contexts.size(); ++i)
+      {
+         threads.emplace_back
+            (  [this, &state, ctx = &contexts[i], i]()
+               {
+                  _context = ctx;
+                  this->run_worker(state, static_cast<unsigned>(i));
+                  _context = nullptr;
+               }
+            );
+      }
+      
+      auto* context = _context;
+      _context = &contexts[0];
+      this->run_worker(state, 0);
+
+      for(auto& t : threads)
+      {
+         t.join();
+      }
+
+      // Exclusive tests, on the calling thread while the other workers are done
+      state._scheduler.release_exclusive(0);
+      this->run_worker(state, 0);
+      _context = context;
    }
    
    // Stop timer
    _timer.stop();
+
+   // Collect statistics
+   for(const auto& ctx : contexts)
+   {
+      this->_counter += ctx._counter;
+   }
+
+   // Update history with durations of this run. Not in sharded runs, as nodes would then write
+   // diverging (or overwrite each other's) history, and balanced plans would differ between nodes.
+   if(!opts._history_file.empty() && opts._shard_count <= 1 && !state._exception)
+   {
+      for(std::size_t i = 0; i < state._tests.size(); ++i)
+      {
+         history.record(names[state._tests[i]], state._durations[i]);
+      }
+      if(!history.save(opts._history_file))
+      {
+         std::cerr << "cutee: could not write history file '" << opts._history_file << "'." << std::endl;
+      }
+   }
+
+   // Rewrite baselines with results of this run (tests not run keep their old baseline)
+   if(detail::baselines()._store == &baselines && detail::baselines()._update && !state._exception)
+   {
+      if(!baselines.save(opts._baseline_file))
+      {
+         std::cerr << "cutee: could not write baseline file '" << opts._baseline_file << "'." << std::endl;
+      }
+   }
+   // Restore settings of an enclosing run (if any)
+   detail::baselines() = outer_baselines;
+   numeric::detail::suite_workers() = outer_workers;
+   
+   // Restore and rethrow if a test escaped the error handling
+   asserter::__set_suite_ptr(suite_ptr);
+   if(state._exception)
+   {
+      this->_writer->flush();
+      this->_writer = writer_ptr_t{nullptr};
+      std::rethrow_exception(state._exception);
+   }
    
    // Print footer
+   this->_writer->end_suite
+      (  suite_summary
+         {  this->_name
+         ,  _counter._num_tests
+         ,  _counter._num_assertions
+         ,  _counter._num_failed
+         ,  _timer.tot_clocks_per_sec()
+         }
+      );
    this->_writer->write(this->create_statistics_message());
    this->_writer->write(this->create_footer_message());
+   this->_writer->flush();
    
    // Clean-up
-   asserter::__unset_suite_ptr();
    this->_writer = writer_ptr_t{nullptr};
 
    return this->_counter._num_failed == 0;
@@ -0,0 +1,130 @@
+#pragma once
+#ifndef CUTEE_TAP_WRITER_HPP_INCLUDED
+#define CUTEE_TAP_WRITER_HPP_INCLUDED
+
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "writer.hpp"
+#include "event.hpp"
+#include "escape.hpp"
+
+namespace cutee
+{
+
+/**
+ * Writer streaming TAP version 14. Each suite is a subtest, with a test point for each test
+ * and failures as YAML diagnostics. The plan for the suites is written when the writer is destroyed.
+ **/
+struct tap_writer
+   :  public writer
+{
+   std::ostream&        _os;
+   mutable std::string  _buffer;
+   mutable std::size_t  _num_suites = 0;
+   mutable std::size_t  _num_tests  = 0;   // test points in current suite
+
+   explicit tap_writer(std::ostream& os)
+      :  _os(os)
+   {
+      _os << "TAP version 14\n";
+   }
+
+   ~tap_writer()
+   {
+      _os << "1.." << _num_suites << "\n";
+      _os.flush();
+   }
+
+   //! Rendered text output is not used.
+   void write(const std::string&) const
+   {
+   }
+
+   void flush() const
+   {
+      _os.flush();
+   }
+
+   void begin_suite(const suite_event& event) const
+   {
+      _num_tests = 0;
+      _buffer = "# Subtest: ";
+      append_description(event._name);
+      _buffer += "\n    1.." + std::to_string(event._num_tests) + "\n";
+      this->output();
+   }
+
+   void test_finished(const test_event& event) const
+   {
+      _buffer = event._failed ? "    not ok " : "    ok ";
+      _buffer += std::to_string(++_num_tests) + " - ";
+      append_description(event._name);
+      _buffer += "\n      ---\n      duration_ms: ";
+      detail::append_number(_buffer, event._duration * 1000.0);
+      _buffer += "\n      assertions: " + std::to_string(event._num_assertions) + "\n";
+      if(!event._failures.empty())
+      {
+         _buffer += "      failures:\n";
+         for(const auto& f : event._failures)
+         {
+            _buffer += "        - message: ";
+            detail::append_json_string(_buffer, f._message);
+            _buffer += "\n";
+            if(!f._file.empty())
+            {
+               _buffer += "          at:\n            file: ";
+               detail::append_json_string(_buffer, f._file);
+               _buffer += "\n            line: " + std::to_string(f._line) + "\n";
+            }
+            if(!f._values.empty())
+            {
+               _buffer += "          values:\n";
+               for(const auto& v : f._values)
+               {
+                  _buffer += "            ";
+                  detail::append_json_string(_buffer, v._label);
+                  _buffer += ": ";
+                  detail::append_json_string(_buffer, v._value);
+                  _buffer += "\n";
+               }
+            }
+         }
+      }
+      _buffer += "      ...\n";
+      this->output();
+   }
+
+   void end_suite(const suite_summary& summary) const
+   {
+      _buffer = summary._num_failed ? "not ok " : "ok ";
+      _buffer += std::to_string(++_num_suites) + " - ";
+      append_description(summary._name);
+      _buffer += "\n";
+      this->output();
+   }
+
+   private:
+      //! Descriptions must not contain unescaped '#' (directive) or newlines.
+      void append_description(std::string_view str) const
+      {
+         for(char c : str)
+         {
+            if(c == '#' || c == '\\')
+            {
+               _buffer += '\\';
+            }
+            _buffer += (c == '\n') ? ' ' : c;
+         }
+      }
+
+      void output() const
+      {
+         _os.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+      }
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_TAP_WRITER_HPP_INCLUDED */
@@ -120,6 +120,12 @@ struct test_impl
          }
       }
       
+      // name the test was registered with (without the name given by T)
+      const std::string& registered_name() const
+      {
+         return _name;
+      }
+
       // interface function for getting name of test
       virtual std::string name() const override
       {
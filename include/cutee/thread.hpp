@@ -0,0 +1,203 @@
+#pragma once
+#ifndef CUTEE_THREAD_HPP_INCLUDED
+#define CUTEE_THREAD_HPP_INCLUDED
+
+#include <thread>
+#include <string>
+#include <utility>
+#include <exception>
+#include <functional>
+
+#include "suite.hpp"
+
+namespace cutee
+{
+
+/**
+ * Handle to the context of the running test, for passing to other threads.
+ **/
+class test_context
+{
+   private:
+      suite*                  _suite   = nullptr;
+      suite::worker_context*  _context = nullptr;
+
+      friend class context_guard;
+
+   public:
+      /**
+       * Get context of the test running on this thread (or adopted by this thread).
+       **/
+      static test_context current()
+      {
+         test_context ctx;
+         ctx._suite   = asserter::_suite_ptr;
+         ctx._context = suite::_context;
+         if(ctx._context && ctx._context->_owner)
+         {
+            ctx._context = ctx._context->_owner;
+         }
+         return ctx;
+      }
+
+      /**
+       * Is there a test to adopt.
+       **/
+      explicit operator bool() const
+      {
+         return _suite && _context;
+      }
+};
+
+/**
+ * Makes the calling thread part of a test for the lifetime of the guard,
+ * so assertions can be used from threads started by the test.
+ *
+ * Assertions are counted on a context local to the thread, and soft failures are recorded there.
+ * When the guard is destroyed the count is added atomically to the test, and the failures are
+ * described and pushed onto the lock-free failure queue of the test, which is emptied when the test ends.
+ * The test must therefore join its threads (or destroy their guards) before it returns.
+ *
+ * A failing fatal assertion throws as usual on the adopted thread. Use 'fail' to report it,
+ * or use cutee::thread, which does this.
+ **/
+class context_guard
+{
+   private:
+      suite::worker_context  _local;
+      suite::worker_context* _owner;
+      suite*                 _previous_suite;
+      suite::worker_context* _previous_context;
+
+   public:
+      explicit context_guard(const test_context& ctx)
+         :  _owner           (ctx._context)
+         ,  _previous_suite  (asserter::_suite_ptr)
+         ,  _previous_context(suite::_context)
+      {
+         if(ctx)
+         {
+            // Failures on this thread are limited as those of the test
+            _local._owner  = _owner;
+            _local._budget = _owner->_budget;
+            _local._soft.set_max(_owner->_soft.max());
+            asserter::__set_suite_ptr(ctx._suite);
+            suite::_context = &_local;
+         }
+      }
+
+      context_guard(const context_guard&) = delete;
+      context_guard& operator=(const context_guard&) = delete;
+
+      ~context_guard()
+      {
+         if(_owner)
+         {
+            _owner->_shared._num_assertions.fetch_add(_local._counter._num_assertions, std::memory_order_relaxed);
+            if(!_local._soft.empty())
+            {
+               std::vector<failure_event> failures;
+               _local._soft.collect(failures);
+
+               // Keep within the bytes per test, the limit of the run is applied with the other failures of the test
+               std::size_t max   = _local._budget ? _local._budget->_max_test : 0;
+               std::size_t bytes = 0;
+               std::size_t keep  = 0;
+               for(; keep < failures.size(); ++keep)
+               {
+                  if(keep > 0 && max && bytes + failures[keep]._text.size() > max)
+                  {
+                     break;
+                  }
+                  bytes += failures[keep]._text.size();
+               }
+               if(keep < failures.size())
+               {
+                  auto note = "   ... " + std::to_string(failures.size() - keep) + " more failures not shown (limit of " + std::to_string(max) + " bytes of failure messages per test)\n";
+                  failures.resize(keep);
+                  failures.emplace_back(failure_event{"failure messages not shown", "", 0, {}, std::move(note)});
+               }
+
+               for(auto& f : failures)
+               {
+                  _owner->_shared._failures.push(std::move(f));
+               }
+            }
+            asserter::__set_suite_ptr(_previous_suite);
+            suite::_context = _previous_context;
+         }
+      }
+
+      /**
+       * Report failure (e.g. from a caught assertion_failed) to the test.
+       **/
+      void fail(failure_event&& failure)
+      {
+         if(_owner)
+         {
+            _owner->_shared._failures.push(std::move(failure));
+         }
+      }
+
+      /**
+       * Report failure described by a message (as rendered in the text output) to the test.
+       **/
+      void fail(std::string&& text)
+      {
+         failure_event failure;
+         failure._message = text;
+         failure._text    = std::move(text);
+         this->fail(std::move(failure));
+      }
+};
+
+/**
+ * std::thread that adopts the context of the test starting it, so assertions can be used in the thread.
+ * A failing fatal assertion (or other exception) ends the thread and is reported as a failure of the test.
+ **/
+class thread
+   :  public std::thread
+{
+   public:
+      thread() noexcept = default;
+
+      template<class F, class... Args>
+      explicit thread(F&& f, Args&&... args)
+         :  std::thread
+            (  [ctx = test_context::current()](auto&& fcn, auto&&... as)
+               {
+                  context_guard guard(ctx);
+                  try
+                  {
+                     std::invoke(std::forward<decltype(fcn)>(fcn), std::forward<decltype(as)>(as)...);
+                  }
+                  catch(const exception::assertion_failed& e)
+                  {
+                     guard.fail(failure_event(e._failure));
+                  }
+                  catch(const exception::failed& e)
+                  {
+                     guard.fail(e.what());
+                  }
+                  catch(const std::exception& e)
+                  {
+                     guard.fail(std::string{"   std::exception in thread\n"} + e.what() + "\n");
+                  }
+                  catch(...)
+                  {
+                     guard.fail("   cutee::thread caught \"something\"...\n");
+                  }
+               }
+            ,  std::forward<F>(f)
+            ,  std::forward<Args>(args)...
+            )
+      {
+      }
+
+      thread(thread&&) noexcept = default;
+      thread& operator=(thread&&) noexcept = default;
+};
+
+} /* namespace cutee */
+
+#endif /* CUTEE_THREAD_HPP_INCLUDED */
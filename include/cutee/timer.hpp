@@ -3,102 +3,431 @@
 #define CUTEE_TIMER_HPP
 
 #include <ctime>
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <sstream>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+#include "typedef.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h>
+#include <cpuid.h>
+#define CUTEE_HAVE_TSC 1
+#endif /* x86 */
 
 namespace cutee
 {
 
+/**
+ * Clock policies for clock_timer. A policy has a tick type, 'now()' in ticks,
+ * 'seconds(ticks)' for converting ticks to seconds, and a 'name()'.
+ **/
+namespace clocks
+{
+
+using tick_type = std::int64_t;
+
+/**
+ * Monotonic wall clock (std::chrono::steady_clock), in nanoseconds.
+ **/
+struct steady
+{
+   static tick_type now()
+   {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+   }
+
+   static double seconds(tick_type ticks)
+   {
+      return double(ticks) * 1e-9;
+   }
+
+   static const char* name()
+   {
+      return "wall";
+   }
+};
+
+/**
+ * CPU time of the calling thread, in nanoseconds (falls back to the wall clock where not available).
+ **/
+struct thread_cpu
+{
+   static tick_type now()
+   {
+#if defined(CUTEE_HAVE_POSIX) && defined(CLOCK_THREAD_CPUTIME_ID)
+      timespec ts;
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+      return tick_type(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+      return steady::now();
+#endif /* CUTEE_HAVE_POSIX && CLOCK_THREAD_CPUTIME_ID */
+   }
+
+   static double seconds(tick_type ticks)
+   {
+      return double(ticks) * 1e-9;
+   }
+
+   static const char* name()
+   {
+      return "thread cpu";
+   }
+};
+
+/**
+ * CPU time of the process (all threads), in nanoseconds where available, otherwise std::clock() ticks.
+ **/
+struct process_cpu
+{
+   static tick_type now()
+   {
+#if defined(CUTEE_HAVE_POSIX) && defined(CLOCK_PROCESS_CPUTIME_ID)
+      timespec ts;
+      clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+      return tick_type(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+      return tick_type(std::clock());
+#endif /* CUTEE_HAVE_POSIX && CLOCK_PROCESS_CPUTIME_ID */
+   }
+
+   static double seconds(tick_type ticks)
+   {
+#if defined(CUTEE_HAVE_POSIX) && defined(CLOCK_PROCESS_CPUTIME_ID)
+      return double(ticks) * 1e-9;
+#else
+      return double(ticks) / CLOCKS_PER_SEC;
+#endif /* CUTEE_HAVE_POSIX && CLOCK_PROCESS_CPUTIME_ID */
+   }
+
+   static const char* name()
+   {
+      return "process cpu";
+   }
+};
+
+/**
+ * Time stamp counter, in cycles. Only used if the CPU has an invariant TSC (constant rate, not stopping in sleep states),
+ * otherwise the wall clock is used. The rate is calibrated against the wall clock once, on first use.
+ **/
+struct tsc
+{
+   //! Is an invariant TSC used.
+   static bool available()
+   {
+#ifdef CUTEE_HAVE_TSC
+      static const bool invariant = []()
+      {
+         unsigned eax, ebx, ecx, edx;
+         return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8));
+      }();
+      return invariant;
+#else
+      return false;
+#endif /* CUTEE_HAVE_TSC */
+   }
+
+   static tick_type now()
+   {
+#ifdef CUTEE_HAVE_TSC
+      if(CUTEE_LIKELY(available()))
+      {
+         _mm_lfence();
+         return tick_type(__rdtsc());
+      }
+#endif /* CUTEE_HAVE_TSC */
+      return steady::now();
+   }
+
+   //! Ticks per second.
+   static double frequency()
+   {
+      static const double hz = []()
+      {
+         if(!available())
+         {
+            return 1e9;
+         }
+         auto w0 = steady::now();
+         auto t0 = now();
+         while(steady::now() - w0 < 10000000)  // 10 ms
+         {
+         }
+         auto w1 = steady::now();
+         auto t1 = now();
+         return double(t1 - t0) / steady::seconds(w1 - w0);
+      }();
+      return hz;
+   }
+
+   static double seconds(tick_type ticks)
+   {
+      return double(ticks) / frequency();
+   }
+
+   static const char* name()
+   {
+      return available() ? "tsc" : "tsc (wall)";
+   }
+};
+
+/**
+ * Overhead of reading a clock, in ticks: the median of back-to-back reads, measured once on first use.
+ **/
+template<class Clock>
+tick_type overhead()
+{
+   static const tick_type ticks = []()
+   {
+      constexpr int n = 101;
+      std::vector<tick_type> samples(n);
+      for(auto& s : samples)
+      {
+         auto t0 = Clock::now();
+         auto t1 = Clock::now();
+         s = t1 - t0;
+      }
+      std::nth_element(samples.begin(), samples.begin() + n / 2, samples.end());
+      return samples[n / 2];
+   }();
+   return ticks;
+}
+
+} /* namespace clocks */
+
+/**
+ * Timer measuring with a clock policy (see cutee::clocks). The overhead of reading the clock
+ * is subtracted from measured intervals.
+ **/
+template<class Clock = clocks::steady>
 class clock_timer
 {
+   public:
+      using clock_type = Clock;
+      using tick_type  = clocks::tick_type;
+
    private:
-      bool    m_running;
-      clock_t m_start;
-      clock_t m_last;
-      clock_t m_stop;
-      clock_t m_clocks_tot;
-      clock_t m_clocks_rel;
-      
+      bool      m_running;
+      tick_type m_start;
+      tick_type m_last;
+      tick_type m_stop;
+      tick_type m_clocks_tot;
+      tick_type m_clocks_rel;
+      tick_type m_clocks_acc;
+      tick_type m_overhead;
+
       //
       // get current clock
       //
-      void get_time(clock_t& a_clock) const
-      { 
-         a_clock = clock(); 
+      void get_time(tick_type& a_clock) const
+      {
+         a_clock = Clock::now();
       }
-      
+
       //
-      // calculate clock difference
+      // calculate clock difference, without the overhead of reading the clock
       //
-      void accu_clock(clock_t a_beg, clock_t a_end, clock_t& a_accu) const
-      { 
-         a_accu = a_end - a_beg; 
+      void accu_clock(tick_type a_beg, tick_type a_end, tick_type& a_accu) const
+      {
+         a_accu = a_end - a_beg - m_overhead;
+         if(a_accu < 0)
+         {
+            a_accu = 0;
+         }
       }
 
    public:
       clock_timer(): m_running(false)
-                   , m_start(0.0) 
-                   , m_last(0.0) 
-                   , m_stop(0.0)
-                   , m_clocks_tot(0.0)
-                   , m_clocks_rel(0.0)
-      { 
-      }
-      
+                   , m_start(0)
+                   , m_last(0)
+                   , m_stop(0)
+                   , m_clocks_tot(0)
+                   , m_clocks_rel(0)
+                   , m_clocks_acc(0)
+                   , m_overhead(clocks::overhead<Clock>())
+      {
+      }
+
       //
       // start the clock
       //
       void start()
-      { 
+      {
          m_running = true;
-         get_time(m_start); 
+         get_time(m_start);
+         m_last = m_start;
       }
-      
+
       //
       //
       //
       void meassure()
-      { 
-         if(m_running) 
+      {
+         if(m_running)
          {
-            clock_t now = clock();
+            tick_type now = Clock::now();
             accu_clock(m_last,now,m_clocks_rel);
-            m_last = now; 
+            m_last = now;
          }
       }
-      
+
       //
       // stop the clock
       //
       void stop()
-      { 
-         if(m_running) 
-         { 
-            get_time(m_stop); 
+      {
+         if(m_running)
+         {
+            get_time(m_stop);
             accu_clock(m_start,m_stop,m_clocks_tot);
+            m_clocks_acc += m_clocks_tot;
             m_running = false;
-         } 
+         }
       }
-      
+
       //
-      // some getters
+      // reset accumulated time
       //
-      clock_t tot_clocks() const
-      { 
-         return m_clocks_tot; 
+      void reset()
+      {
+         m_running    = false;
+         m_clocks_tot = 0;
+         m_clocks_rel = 0;
+         m_clocks_acc = 0;
       }
 
-      clock_t rel_clocks() const
-      { 
-         return m_clocks_rel; 
+      //
+      // some getters (tot is the last start/stop interval, acc the sum of all intervals since construction or reset)
+      //
+      tick_type tot_clocks() const
+      {
+         return m_clocks_tot;
+      }
+
+      tick_type rel_clocks() const
+      {
+         return m_clocks_rel;
       }
 
-      double tot_clocks_per_sec() const 
-      { 
-         return double(m_clocks_tot)/CLOCKS_PER_SEC; 
+      double tot_clocks_per_sec() const
+      {
+         return Clock::seconds(m_clocks_tot);
       }
-      
+
       double rel_clocks_per_sec() const
-      { 
-         return double(m_clocks_rel)/CLOCKS_PER_SEC; 
+      {
+         return Clock::seconds(m_clocks_rel);
+      }
+
+      tick_type acc_clocks() const
+      {
+         return m_clocks_acc;
+      }
+
+      double acc_clocks_per_sec() const
+      {
+         return Clock::seconds(m_clocks_acc);
+      }
+
+      static const char* name()
+      {
+         return Clock::name();
+      }
+};
+
+/**
+ * Several clock_timers started and stopped together, for reporting several clocks side by side.
+ * The first clock is the primary one, used by 'tot_clocks_per_sec'.
+ *
+ * Clocks are started last to first and stopped first to last, so the intervals nest with the primary
+ * clock innermost: it does not include reads of the other clocks, and each other clock only includes
+ * reads of the clocks inside it (a few tens of nanoseconds), never those of clocks outside it.
+ **/
+template<class... Clocks>
+class multi_timer
+{
+   private:
+      std::tuple<clock_timer<Clocks>...> m_timers;
+
+      template<class F, std::size_t... Is>
+      void for_each_impl(F& f, std::index_sequence<Is...>) const
+      {
+         (f(Is, std::get<Is>(m_timers)), ...);
+      }
+
+      template<std::size_t... Is>
+      void start_impl(std::index_sequence<Is...>)
+      {
+         (std::get<sizeof...(Clocks) - 1 - Is>(m_timers).start(), ...);
+      }
+
+   public:
+      static constexpr std::size_t size = sizeof...(Clocks);
+
+      void reset()
+      {
+         std::apply([](auto&... timers) { (timers.reset(), ...); }, m_timers);
+      }
+
+      //! Start clocks in reverse order (primary last).
+      void start()
+      {
+         this->start_impl(std::index_sequence_for<Clocks...>{});
+      }
+
+      //! Stop clocks in order (primary first).
+      void stop()
+      {
+         std::apply([](auto&... timers) { (timers.stop(), ...); }, m_timers);
+      }
+
+      template<class Clock>
+      const clock_timer<Clock>& get() const
+      {
+         return std::get<clock_timer<Clock> >(m_timers);
+      }
+
+      double tot_clocks_per_sec() const
+      {
+         return std::get<0>(m_timers).tot_clocks_per_sec();
+      }
+
+      //! Name of clock number 'I'.
+      template<std::size_t I>
+      static const char* name()
+      {
+         return std::tuple_element_t<I, std::tuple<Clocks...> >::name();
+      }
+
+      /**
+       * Call 'f(index, timer)' for the timer of each clock.
+       **/
+      template<class F>
+      void for_each(F&& f) const
+      {
+         this->for_each_impl(f, std::index_sequence_for<Clocks...>{});
+      }
+
+      /**
+       * Accumulated time of each clock, e.g. "0.52s (wall), 1.9s (process cpu)".
+       **/
+      std::string report() const
+      {
+         std::stringstream sstr;
+         bool first = true;
+         std::apply
+            (  [&sstr, &first](const auto&... timers)
+               {
+                  ((sstr << (first ? "" : ", ") << timers.acc_clocks_per_sec() << "s (" << timers.name() << ")", first = false), ...);
+               }
+            ,  m_timers
+            );
+         return sstr.str();
       }
 };
 
@@ -4,4 +4,18 @@
 
 #define Cutee_thread_local thread_local
 
+#if defined(__GNUC__) || defined(__clang__)
+#define CUTEE_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define CUTEE_LIKELY(x) __builtin_expect(!!(x), 1)
+#define CUTEE_NOINLINE __attribute__((noinline))
+#else
+#define CUTEE_UNLIKELY(x) (x)
+#define CUTEE_LIKELY(x) (x)
+#define CUTEE_NOINLINE
+#endif /* __GNUC__ || __clang__ */
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CUTEE_HAVE_POSIX 1
+#endif /* __unix__ || __APPLE__ */
+
 #endif /* CUTEE_TYPEDEF_HPP_INCLUDED */
@@ -6,8 +6,12 @@
 #include <memory>
 #include <string>
 #include <tuple>
+#include <vector>
+#include <string_view>
+#include <algorithm>
 
 #include "formater.hpp"
+#include "event.hpp"
 
 namespace cutee
 {
@@ -16,6 +20,27 @@ struct writer
 {
    virtual ~writer() = default;
    virtual void write(const std::string& msg) const = 0;
+
+   //! Make sure everything written so far has reached its destination.
+   virtual void flush() const
+   {
+   }
+
+   /**
+    * Structured events, for writers not using the rendered text passed to 'write'.
+    * Called in test order, and never concurrently.
+    **/
+   virtual void begin_suite(const suite_event&) const
+   {
+   }
+
+   virtual void test_finished(const test_event&) const
+   {
+   }
+
+   virtual void end_suite(const suite_summary&) const
+   {
+   }
 };
 
 struct formated_writer
@@ -24,10 +49,13 @@ struct formated_writer
    using formater_ptr_t = typename format::formater_ptr_t;
    
    std::ostream&  _os         = std::cout;
+   format         _format     = format::fancy;
    formater_ptr_t _formater   = formater_ptr_t{nullptr};
+   mutable std::string _buffer;  // reused for formatting, so writing does not allocate once warmed up
 
    formated_writer(std::ostream& os, const format& form)
       :  _os(os)
+      ,  _format(form)
       ,  _formater(format::create(form))
    {
    }
@@ -39,14 +67,46 @@ struct formated_writer
 
    void write(const std::string& msg) const
    {
-      _os << this->_formater->replace_in_string_copy(msg);
+      _buffer.clear();
+      this->_formater->replace_into(msg, _buffer);
+      this->write_formatted(_buffer);
+   }
+
+   /**
+    * Write message already formatted with this writer's format.
+    **/
+   void write_formatted(std::string_view formatted) const
+   {
+      _os.write(formatted.data(), static_cast<std::streamsize>(formatted.size()));
+   }
+
+   void flush() const
+   {
+      _os.flush();
    }
 };
 
+/**
+ * Writer writing to several streams (and other writers).
+ *
+ * Streams are grouped by format, and each message is formatted once per group
+ * into a buffer shared by all streams of the group.
+ **/
 struct writer_collection
    :  public writer
 {
-   std::vector<std::unique_ptr<writer> > _writers;
+   using formater_ptr_t = typename format::formater_ptr_t;
+
+   struct group
+   {
+      format                                         _format;
+      formater_ptr_t                                 _formater;
+      std::vector<std::unique_ptr<formated_writer> > _writers;
+   };
+
+   std::vector<group>                    _groups;
+   std::vector<std::unique_ptr<writer> > _writers;   // other writers (e.g. structured)
+   mutable std::string                   _buffer;
 
    template<class... Ts>
    writer_collection(Ts&&... ts)
@@ -57,7 +117,7 @@ struct writer_collection
    template<class T, class... Ts>
    void initialize(T&& t, Ts&&... ts)
    {
-      _writers.emplace_back(std::unique_ptr<writer>{new formated_writer{std::get<0>(t), std::get<1>(t)}});
+      this->add(std::get<0>(t), std::get<1>(t));
       initialize(std::forward<Ts>(ts)...);
    }
    
@@ -65,13 +125,83 @@ struct writer_collection
    {
    }
 
+   /**
+    * Add stream written with format.
+    **/
+   void add(std::ostream& os, const format& form)
+   {
+      auto iter = std::find_if(_groups.begin(), _groups.end(), [&form](const group& g) { return g._format._value == form._value; });
+      if(iter == _groups.end())
+      {
+         _groups.emplace_back(group{form, format::create(form), {}});
+         iter = _groups.end() - 1;
+      }
+      iter->_writers.emplace_back(new formated_writer{os, form});
+   }
+
+   /**
+    * Add any other writer.
+    **/
+   void add(std::unique_ptr<writer>&& w)
+   {
+      _writers.emplace_back(std::move(w));
+   }
+
    void write(const std::string& msg) const
    {
+      for(const auto& g : _groups)
+      {
+         _buffer.clear();
+         g._formater->replace_into(msg, _buffer);
+         for(const auto& w : g._writers)
+         {
+            w->write_formatted(_buffer);
+         }
+      }
       for(const auto& w : _writers)
       {
          w->write(msg);
       }
    }
+
+   void begin_suite(const suite_event& event) const
+   {
+      for(const auto& w : _writers)
+      {
+         w->begin_suite(event);
+      }
+   }
+
+   void test_finished(const test_event& event) const
+   {
+      for(const auto& w : _writers)
+      {
+         w->test_finished(event);
+      }
+   }
+
+   void end_suite(const suite_summary& summary) const
+   {
+      for(const auto& w : _writers)
+      {
+         w->end_suite(summary);
+      }
+   }
+
+   void flush() const
+   {
+      for(const auto& g : _groups)
+      {
+         for(const auto& w : g._writers)
+         {
+            w->flush();
+         }
+      }
+      for(const auto& w : _writers)
+      {
+         w->flush();
+      }
+   }
 };
 
 } /* namespace cutee */
@@ -0,0 +1,148 @@
+/**
+ * Replacement of the global operator new/delete counting allocations per thread (see cutee/alloc.hpp).
+ * Built as the separate 'cutee_alloc' library, linked only into test programs that want allocation accounting.
+ **/
+#include <new>
+#include <cstdlib>
+#include <utility>
+
+#include "../../include/cutee/alloc.hpp"
+
+namespace
+{
+
+// Allocations are counted from when this library is loaded
+struct install
+{
+   install()
+   {
+      cutee::alloc::detail::installed.store(true, std::memory_order_relaxed);
+   }
+} installer;
+
+inline void count(std::size_t size)
+{
+   if(!cutee::alloc::detail::suspended)
+   {
+      auto& c = cutee::alloc::detail::current;
+      ++c._allocations;
+      c._bytes += size;
+   }
+}
+
+inline void* try_allocate(std::size_t size)
+{
+   return std::malloc(size ? size : 1);
+}
+
+inline void* try_allocate_aligned(std::size_t size, std::align_val_t align)
+{
+   auto alignment = static_cast<std::size_t>(align);
+   if(alignment < sizeof(void*))
+   {
+      alignment = sizeof(void*);
+   }
+   void* ptr = nullptr;
+   return posix_memalign(&ptr, alignment, size ? size : 1) == 0 ? ptr : nullptr;
+}
+
+// As the standard operator new: call the new handler until the allocation succeeds, throw std::bad_alloc if there is none
+template<class F>
+void* allocate(std::size_t size, F&& attempt)
+{
+   count(size);
+   for(;;)
+   {
+      if(auto ptr = attempt())
+      {
+         return ptr;
+      }
+      auto handler = std::get_new_handler();
+      if(!handler)
+      {
+         throw std::bad_alloc();
+      }
+      handler();
+   }
+}
+
+// As the standard nothrow operator new: the throwing version, returning nullptr instead of throwing
+template<class F>
+void* allocate_nothrow(std::size_t size, F&& attempt) noexcept
+{
+   try
+   {
+      return allocate(size, std::forward<F>(attempt));
+   }
+   catch(...)
+   {
+      return nullptr;
+   }
+}
+
+inline void deallocate(void* ptr) noexcept
+{
+   if(ptr)
+   {
+      if(!cutee::alloc::detail::suspended)
+      {
+         ++cutee::alloc::detail::current._frees;
+      }
+      std::free(ptr);
+   }
+}
+
+} /* namespace */
+
+void* operator new(std::size_t size)
+{
+   return allocate(size, [size]() { return try_allocate(size); });
+}
+
+void* operator new[](std::size_t size)
+{
+   return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+   return allocate_nothrow(size, [size]() { return try_allocate(size); });
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+   return ::operator new(size, std::nothrow);
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+   return allocate(size, [size, align]() { return try_allocate_aligned(size, align); });
+}
+
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+   return ::operator new(size, align);
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+   return allocate_nothrow(size, [size, align]() { return try_allocate_aligned(size, align); });
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+   return ::operator new(size, align, std::nothrow);
+}
+
+void operator delete(void* ptr) noexcept                                              { deallocate(ptr); }
+void operator delete[](void* ptr) noexcept                                            { deallocate(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept                                 { deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept                               { deallocate(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept                       { deallocate(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept                     { deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept                            { deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept                          { deallocate(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept               { deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept             { deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept     { deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept   { deallocate(ptr); }
@@ -0,0 +1,34 @@
+#include "../include/cutee/typedef.hpp"
+#include "../include/cutee/suite.hpp"
+#include "../include/cutee/alloc.hpp"
+
+namespace cutee
+{
+
+/**
+ * Record a soft failure if the region allocated. Nothing is allocated unless it fails.
+ **/
+no_alloc_region::~no_alloc_region()
+{
+   if(!asserter::_suite_ptr)
+   {
+      return;
+   }
+
+   auto got = this->allocations();
+   if(!alloc::tracking())
+   {
+      asserter::assertt<severity::soft>
+         (  false
+         ,  make_info([]() { return "no_alloc_region: allocations are not counted (link with cutee_alloc)"; }, _file, _line)
+         );
+      return;
+   }
+   asserter::assert_equal<severity::soft>
+      (  got._allocations
+      ,  std::uint64_t{0}
+      ,  make_info([got]() { return "allocations in no_alloc_region (" + std::to_string(got._bytes) + " bytes)"; }, _file, _line)
+      );
+}
+
+} /* namespace cutee */
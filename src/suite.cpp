@@ -0,0 +1,9 @@
+#include "../include/cutee/typedef.hpp"
+#include "../include/cutee/suite.hpp"
+
+namespace cutee
+{
+
+Cutee_thread_local suite::worker_context* suite::_context = nullptr;
+
+} /* namespace cutee */
@@ -0,0 +1,187 @@
+/**
+ * cutee-report: render and query binary result logs written by cutee::binary_log_writer.
+ *
+ *    cutee-report [options] <log>
+ *
+ *    --format text|junit|json   Output format (default text).
+ *    --failed                   Only failed tests.
+ *    --test <glob>              Only tests with a name matching glob.
+ *    --file <glob>              Only failures in files matching glob (implies --failed).
+ *
+ * The log is memory mapped and read in a single pass, keeping only one test in memory at a time.
+ **/
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "../include/cutee/binary_log.hpp"
+#include "../include/cutee/filter.hpp"
+#include "../include/cutee/junit_writer.hpp"
+#include "../include/cutee/jsonl_writer.hpp"
+
+namespace
+{
+
+/**
+ * Plain text rendering of structured events, in the layout of the raw suite output.
+ **/
+struct text_writer
+   :  public cutee::writer
+{
+   using formater_ptr_t = typename cutee::format::formater_ptr_t;
+
+   std::ostream&       _os;
+   formater_ptr_t      _raw = cutee::format::create(cutee::format::raw);
+   mutable std::string _buffer;
+
+   explicit text_writer(std::ostream& os)
+      :  _os(os)
+   {
+   }
+
+   void write(const std::string&) const
+   {
+   }
+
+   void begin_suite(const cutee::suite_event& event) const
+   {
+      _os << " Running Unit Tests for suite '" << event._name << "' (" << event._num_tests << " tests)\n";
+   }
+
+   void test_finished(const cutee::test_event& event) const
+   {
+      _os << (event._failed ? " FAILED " : " PASSED ") << event._name << " (" << event._duration << " s, " << event._num_assertions << " assertions)\n";
+      for(const auto& f : event._failures)
+      {
+         this->output(f._text);
+      }
+      this->output(event._output);
+   }
+
+   void output(const std::string& text) const
+   {
+      _buffer.clear();
+      _raw->replace_into(text, _buffer);
+      if(!_buffer.empty() && _buffer.back() != '\n')
+      {
+         _buffer += '\n';
+      }
+      _os << _buffer;
+   }
+
+   void end_suite(const cutee::suite_summary& summary) const
+   {
+      _os << " Suite '" << summary._name << "': " << summary._num_tests << " tests, " << summary._num_assertions << " assertions, "
+          << summary._num_failed << " failed, " << summary._duration << " s\n";
+   }
+};
+
+int usage(const char* name)
+{
+   std::cerr << "Usage: " << name << " [--format text|junit|json] [--failed] [--test <glob>] [--file <glob>] <log>\n";
+   return 2;
+}
+
+} /* namespace */
+
+int main(int argc, char* argv[])
+{
+   std::string format = "text";
+   std::string path;
+   std::string test_glob;
+   std::string file_glob;
+   bool        failed_only = false;
+
+   for(int i = 1; i < argc; ++i)
+   {
+      std::string arg = argv[i];
+      if(arg == "--format" && i + 1 < argc)
+      {
+         format = argv[++i];
+      }
+      else if(arg == "--failed")
+      {
+         failed_only = true;
+      }
+      else if(arg == "--test" && i + 1 < argc)
+      {
+         test_glob = argv[++i];
+      }
+      else if(arg == "--file" && i + 1 < argc)
+      {
+         file_glob   = argv[++i];
+         failed_only = true;
+      }
+      else if(arg.size() > 0 && arg[0] != '-' && path.empty())
+      {
+         path = arg;
+      }
+      else
+      {
+         return usage(argv[0]);
+      }
+   }
+
+   if(path.empty())
+   {
+      return usage(argv[0]);
+   }
+
+   std::unique_ptr<cutee::writer> w;
+   if(format == "text")
+   {
+      w.reset(new text_writer(std::cout));
+   }
+   else if(format == "junit")
+   {
+      w.reset(new cutee::junit_writer(std::cout));
+   }
+   else if(format == "json")
+   {
+      w.reset(new cutee::jsonl_writer(std::cout));
+   }
+   else
+   {
+      return usage(argv[0]);
+   }
+
+   try
+   {
+      cutee::binary_log_reader reader(path);
+      reader.replay
+         (  *w
+         ,  [&](cutee::test_event& event)
+            {
+               if(failed_only && !event._failed)
+               {
+                  return false;
+               }
+               if(!test_glob.empty() && !cutee::detail::glob_match(test_glob, event._name))
+               {
+                  return false;
+               }
+               if(!file_glob.empty())
+               {
+                  auto& failures = event._failures;
+                  failures.erase
+                     (  std::remove_if(failures.begin(), failures.end(), [&file_glob](const cutee::failure_event& f) { return !cutee::detail::glob_match(file_glob, f._file); })
+                     ,  failures.end()
+                     );
+                  return !failures.empty();
+               }
+               return true;
+            }
+         );
+   }
+   catch(const std::exception& e)
+   {
+      std::cerr << e.what() << std::endl;
+      return 1;
+   }
+
+   w->flush();
+   return 0;
+}